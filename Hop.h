@@ -63,6 +63,63 @@ For more information, please refer to <http://unlicense.org/>
 #define HOP_MIN_LOCK_CYCLES 1000
 #endif
 
+// By default, the traces of a thread are only sent to the viewer once its
+// outermost trace ends. A thread whose top-level trace never ends (e.g. a
+// worker's event loop) would therefore never show up in the viewer. The traces
+// are also flushed while nested once more than HOP_MAX_FLUSH_INTERVAL cycles
+// (or nanoseconds if HOP_USE_STD_CHRONO is set) have elapsed since the last
+// flush, or once HOP_MAX_PENDING_TRACES traces are waiting to be sent. Setting
+// either of them to 0 disables the corresponding check, although the traces are
+// always flushed before they become too big to fit in the shared memory.
+#if !defined( HOP_MAX_FLUSH_INTERVAL )
+#define HOP_MAX_FLUSH_INTERVAL 30000000
+#endif
+
+#if !defined( HOP_MAX_PENDING_TRACES )
+#define HOP_MAX_PENDING_TRACES 16384
+#endif
+
+// Policy used when a message cannot be written because the shared memory ring
+// buffer is full (ie the viewer is not consuming fast enough)
+//  - HOP_FULL_BUFFER_DROP  : The pending data is dropped
+//  - HOP_FULL_BUFFER_RETRY : The pending data is kept and sent with the next flush.
+//                            It is only dropped if it can never fit in the ring buffer.
+//  - HOP_FULL_BUFFER_SPIN  : Spin for at most HOP_MAX_SPIN_WAIT_CYCLES waiting for the
+//                            viewer to make some room. The data is dropped on timeout.
+// The number of dropped messages and traces are reported per thread to the viewer.
+#define HOP_FULL_BUFFER_DROP 0
+#define HOP_FULL_BUFFER_RETRY 1
+#define HOP_FULL_BUFFER_SPIN 2
+#if !defined( HOP_FULL_BUFFER_POLICY )
+#define HOP_FULL_BUFFER_POLICY HOP_FULL_BUFFER_DROP
+#endif
+
+#if !defined( HOP_MAX_SPIN_WAIT_CYCLES )
+#define HOP_MAX_SPIN_WAIT_CYCLES 1000000
+#endif
+
+// By default, all the threads write their messages in a single multi-producer
+// ring buffer, which they need to synchronize on. Setting this to 1 will instead
+// split the shared memory in HOP_MAX_THREAD_NB single-producer channels, one for
+// each thread, so sending traces does not contend with the other threads. Each
+// thread then only has HOP_SHARED_MEM_SIZE / HOP_MAX_THREAD_NB bytes available.
+#if !defined( HOP_PER_THREAD_CHANNELS )
+#define HOP_PER_THREAD_CHANNELS 0
+#endif
+
+// When the viewer has read everything there is in the shared memory, it parks
+// its reading thread until a producer signals that new data was written rather
+// than polling the shared memory at regular intervals. Producers only pay for
+// the signal when the viewer is actually parked. This relies on futexes and is
+// therefore only available on Linux. The viewer falls back to polling otherwise.
+#if !defined( HOP_CONSUMER_WAKEUP )
+#if defined( __linux__ )
+#define HOP_CONSUMER_WAKEUP 1
+#else
+#define HOP_CONSUMER_WAKEUP 0
+#endif
+#endif
+
 // By default HOP will use a call to RDTSCP to get the current timestamp of the
 // CPU. A mismatch in synchronization was noted on some machine having multiple
 // physical CPUs. This would show up in the viewer as infinitly long traces or
@@ -89,12 +146,12 @@ For more information, please refer to <http://unlicense.org/>
 #define HOP_PROF_FUNC() HOP_PROF_ID_GUARD( hop__, ( __FILE__, __LINE__, HOP_FCT_NAME ) )
 
 // Split a profiling trace with a new provided name. Name must be static.
-#define HOP_PROF_SPLIT( x ) HOP_PROF_ID_SPLIT( hop__, ( __FILE__, __LINE__, ( x ) ) )
+#define HOP_PROF_SPLIT( x ) HOP_PROF_ID_SPLIT( hop__, __LINE__, ( __FILE__, __LINE__, ( x ) ) )
 
 // Create a new profiling trace for dynamic strings. Please use sparingly as they will incur more
 // slowdown
 #define HOP_PROF_DYN_NAME( x ) \
-   HOP_PROF_DYN_STRING_GUARD_VAR( __LINE__, ( __FILE__, __LINE__, ( x ) ) )
+   HOP_PROF_DYN_STRING_GUARD_VAR( __LINE__, ( __FILE__, __LINE__, NULL ), ( x ) )
 
 // Create a trace that represent the time waiting for a mutex. You need to provide
 // a pointer to the mutex that is being locked
@@ -148,7 +205,7 @@ For more information, please refer to <http://unlicense.org/>
 */
 
 // Useful macros
-#define HOP_VERSION 0.93f
+#define HOP_VERSION 0.94f
 #define HOP_ZONE_MAX  255
 #define HOP_ZONE_DEFAULT 0
 #define HOP_CONSTEXPR constexpr
@@ -219,6 +276,9 @@ typedef char HOP_CHAR;
 typedef struct ringbuf ringbuf_t;
 typedef struct ringbuf_worker ringbuf_worker_t;
 // -----------------------------
+// Single producer ring buffer used by the per-thread channels
+typedef struct spscbuf spscbuf_t;
+// -----------------------------
 
 namespace hop
 {
@@ -230,6 +290,7 @@ using LineNb_t     = uint32_t;
 using Core_t       = uint32_t;
 using Depth_t      = uint16_t;
 using ZoneId_t     = uint16_t;
+using Callsite_t   = uint32_t;
 
 #if !HOP_USE_STD_CHRONO
 inline TimeStamp rdtscp( uint32_t& aux )
@@ -276,9 +337,18 @@ enum class MsgType : uint32_t
    INVALID_MESSAGE,
 };
 
+// Encoding used for the traces of a PROFILER_TRACE message
+enum class TraceEncoding : uint32_t
+{
+   // Header followed by the new callsites and the varint encoded traces.
+   // See hop::encodeTraces for the details
+   COMPACT_V1 = 1,
+};
+
 struct TracesMsgInfo
 {
    uint32_t count;
+   TraceEncoding encoding;
 };
 
 struct StringDataMsgInfo
@@ -323,14 +393,34 @@ HOP_STATIC_ASSERT(
     sizeof( MsgInfo ) == EXPECTED_MSG_INFO_SIZE,
     "MsgInfo layout has changed unexpectedly" );
 
+// Header of the COMPACT_V1 traces encoding
+struct CompactTracesHeader
+{
+   uint32_t newCallsiteCount;  // Number of CallsiteInfo following this header
+   uint32_t encodedSize;       // Size in bytes of the encoded traces following the callsites
+};
+
+// The traces identify their (file, function, line) with a callsite id. The ids are
+// registered once per callsite (see ClientManager::RegisterCallsite) and each thread
+// sends the information of a callsite along with the first message that uses it.
+HOP_CONSTEXPR uint32_t EXPECTED_CALLSITE_INFO_SIZE = 24;
+struct CallsiteInfo
+{
+   StrPtr_t fileName;
+   StrPtr_t fctName;
+   LineNb_t lineNb;
+   Callsite_t id;
+};
+HOP_STATIC_ASSERT(
+    sizeof( CallsiteInfo ) == EXPECTED_CALLSITE_INFO_SIZE,
+    "Callsite info layout has changed unexpectedly" );
+
 struct Traces
 {
    uint32_t count;
    uint32_t maxSize;
    TimeStamp *starts, *ends;  // Timestamp for start/end of this trace
-   StrPtr_t* fileNameIds;     // Index into string array for the file name
-   StrPtr_t* fctNameIds;      // Index into string array for the function name
-   LineNb_t* lineNumbers;     // Line at which the trace was inserted
+   Callsite_t* callsiteIds;   // Callsite at which the trace was inserted
    Depth_t* depths;           // The depth in the callstack of this trace
    ZoneId_t* zones;           // Zone to which this trace belongs
 };
@@ -370,14 +460,13 @@ class HOP_API ClientManager
 {
   public:
    static Client* Get();
+   static Callsite_t RegisterCallsite( const char* fileName, LineNb_t lineNb, const char* fctName );
    static ZoneId_t StartProfile();
-   static StrPtr_t StartProfileDynString( const char*, ZoneId_t* );
+   static Callsite_t StartProfileDynString( Callsite_t, const char*, ZoneId_t* );
    static void EndProfile(
-       StrPtr_t fileName,
-       StrPtr_t fctName,
+       Callsite_t callsite,
        TimeStamp start,
        TimeStamp end,
-       LineNb_t lineNb,
        ZoneId_t zone,
        Core_t core );
    static void EndLockWait( void* mutexAddr, TimeStamp start, TimeStamp end );
@@ -395,40 +484,30 @@ class HOP_API ClientManager
 class ProfGuard
 {
   public:
-   ProfGuard( const char* fileName, LineNb_t lineNb, const char* fctName ) HOP_NOEXCEPT
-   {
-      open( fileName, lineNb, fctName );
-   }
+   ProfGuard( Callsite_t callsite ) HOP_NOEXCEPT { open( callsite ); }
    ~ProfGuard() { close(); }
-   inline void reset( const char* fileName, LineNb_t lineNb, const char* fctName )
+   inline void reset( Callsite_t callsite )
    {
-      // Please uncomment the following line if close() is made public!
-      // if ( _fctName )
       close();
-      open( fileName, lineNb, fctName );
+      open( callsite );
    }
 
   private:
-   inline void open( const char* fileName, LineNb_t lineNb, const char* fctName )
+   inline void open( Callsite_t callsite )
    {
       _start    = getTimeStamp();
-      _fileName = reinterpret_cast<StrPtr_t>( fileName );
-      _fctName  = reinterpret_cast<StrPtr_t>( fctName );
-      _lineNb   = lineNb;
+      _callsite = callsite;
       _zone     = ClientManager::StartProfile();
    }
    inline void close()
    {
       uint32_t core;
       const auto end = getTimeStamp( core );
-      ClientManager::EndProfile( _fileName, _fctName, _start, end, _lineNb, _zone, core );
-      // Please uncomment the following line if close() is made public!
-      // _fctName = nullptr;
+      ClientManager::EndProfile( _callsite, _start, end, _zone, core );
    }
 
    TimeStamp _start;
-   StrPtr_t _fileName, _fctName;
-   LineNb_t _lineNb;
+   Callsite_t _callsite;
    ZoneId_t _zone;
 };
 
@@ -444,23 +523,19 @@ class LockWaitGuard
 class ProfGuardDynamicString
 {
   public:
-   ProfGuardDynamicString( const char* fileName, LineNb_t lineNb, const char* fctName ) HOP_NOEXCEPT
-       : _start( getTimeStamp() | 1ULL ),  // Set the first bit to 1 to signal dynamic strings
-         _fileName( reinterpret_cast<StrPtr_t>( fileName ) ),
-         _lineNb( lineNb )
+   ProfGuardDynamicString( Callsite_t callsite, const char* fctName ) HOP_NOEXCEPT
+       : _start( getTimeStamp() | 1ULL )  // Set the first bit to 1 to signal dynamic strings
    {
-      _fctName = ClientManager::StartProfileDynString( fctName, &_zone );
+      _callsite = ClientManager::StartProfileDynString( callsite, fctName, &_zone );
    }
    ~ProfGuardDynamicString()
    {
-      ClientManager::EndProfile( _fileName, _fctName, _start, getTimeStamp(), _lineNb, _zone, 0 );
+      ClientManager::EndProfile( _callsite, _start, getTimeStamp(), _zone, 0 );
    }
 
   private:
    TimeStamp _start;
-   StrPtr_t _fileName;
-   StrPtr_t _fctName;
-   LineNb_t _lineNb;
+   Callsite_t _callsite;
    ZoneId_t _zone;
 };
 
@@ -477,11 +552,23 @@ class ZoneGuard
    ZoneId_t _prevZoneId;
 };
 
-#define HOP_PROF_GUARD_VAR( LINE, ARGS ) hop::ProfGuard HOP_COMBINE( hopProfGuard, LINE ) ARGS
-#define HOP_PROF_ID_GUARD( ID, ARGS ) hop::ProfGuard ID ARGS
-#define HOP_PROF_ID_SPLIT( ID, ARGS ) ID.reset ARGS
-#define HOP_PROF_DYN_STRING_GUARD_VAR( LINE, ARGS ) \
-   hop::ProfGuardDynamicString HOP_COMBINE( hopProfGuard, LINE ) ARGS
+// The callsites are registered once through a function-local static, so the
+// traces only need to carry their callsite id
+#define HOP_CALLSITE_VAR( VAR, ARGS ) \
+   static const hop::Callsite_t VAR = hop::ClientManager::RegisterCallsite ARGS
+#define HOP_PROF_GUARD_VAR( LINE, ARGS )                     \
+   HOP_CALLSITE_VAR( HOP_COMBINE( hopCallsite, LINE ), ARGS ); \
+   hop::ProfGuard HOP_COMBINE( hopProfGuard, LINE )( HOP_COMBINE( hopCallsite, LINE ) )
+#define HOP_PROF_ID_GUARD( ID, ARGS )              \
+   HOP_CALLSITE_VAR( HOP_COMBINE( ID, Callsite ), ARGS ); \
+   hop::ProfGuard ID( HOP_COMBINE( ID, Callsite ) )
+#define HOP_PROF_ID_SPLIT( ID, LINE, ARGS )                  \
+   HOP_CALLSITE_VAR( HOP_COMBINE( hopCallsite, LINE ), ARGS ); \
+   ID.reset( HOP_COMBINE( hopCallsite, LINE ) )
+#define HOP_PROF_DYN_STRING_GUARD_VAR( LINE, ARGS, NAME )                       \
+   HOP_CALLSITE_VAR( HOP_COMBINE( hopCallsite, LINE ), ARGS );                    \
+   hop::ProfGuardDynamicString HOP_COMBINE( hopProfGuard, LINE )( \
+       HOP_COMBINE( hopCallsite, LINE ), NAME )
 #define HOP_MUTEX_LOCK_GUARD_VAR( LINE, ARGS ) \
    hop::LockWaitGuard HOP_COMBINE( hopMutexLock, LINE ) ARGS
 #define HOP_MUTEX_UNLOCK_EVENT( x ) hop::ClientManager::UnlockEvent( x, hop::getTimeStamp() );
@@ -532,6 +619,18 @@ void ringbuf_produce( ringbuf_t*, ringbuf_worker_t* );
 size_t ringbuf_consume( ringbuf_t*, size_t* );
 void ringbuf_release( ringbuf_t*, size_t );
 
+// Single producer single consumer ring buffer used when HOP_PER_THREAD_CHANNELS
+// is set. Its API mirrors the ringbuf one.
+size_t spscbuf_get_size();
+int spscbuf_setup( spscbuf_t*, size_t );
+size_t spscbuf_space( const spscbuf_t* );
+uint8_t* spscbuf_data( spscbuf_t* );
+
+ssize_t spscbuf_acquire( spscbuf_t*, size_t );
+void spscbuf_produce( spscbuf_t* );
+size_t spscbuf_consume( spscbuf_t*, size_t* );
+void spscbuf_release( spscbuf_t*, size_t );
+
 /* ======================================================================
                     End of public declarations
    ==================================================================== */
@@ -574,10 +673,22 @@ class SharedMemory
       uint32_t maxThreadNb{0};
       size_t requestedSize{0};
       bool usingStdChronoTimeStamps{false};
+      bool perThreadChannels{false};
+      bool consumerWakeup{false};
+      // Futex word set by the consumer while it waits for new data
+      std::atomic<uint32_t> consumerParked{0};
       std::atomic<TimeStamp> lastResetTimeStamp{0};
       std::atomic<TimeStamp> lastHeartbeatTimeStamp{0};
    };
 
+   // Data that could not be sent because the ring buffer was full. There is one
+   // entry per thread index, located right after the SharedMetaInfo
+   struct DropCounters
+   {
+      std::atomic<uint32_t> droppedMsgCount{0};
+      std::atomic<uint32_t> droppedTraceCount{0};
+   };
+
    bool hasConnectedProducer() const HOP_NOEXCEPT;
    void setConnectedProducer( bool ) HOP_NOEXCEPT;
    bool hasConnectedConsumer() const HOP_NOEXCEPT;
@@ -590,6 +701,19 @@ class SharedMemory
    void setResetTimestamp( TimeStamp t ) HOP_NOEXCEPT;
    ringbuf_t* ringbuffer() const HOP_NOEXCEPT;
    uint8_t* data() const HOP_NOEXCEPT;
+   uint32_t channelCount() const HOP_NOEXCEPT;  // 0 if not using per-thread channels
+   spscbuf_t* channel( uint32_t threadIndex ) const HOP_NOEXCEPT;
+   DropCounters* dropCounters() const HOP_NOEXCEPT;
+   // Consumer side. Once parked, call waitForProducer if there is still nothing
+   // to read. The wait returns after timeoutMs or once a producer calls wakeConsumer
+   bool canParkConsumer() const HOP_NOEXCEPT;
+   void parkConsumer() HOP_NOEXCEPT;
+   void unparkConsumer() HOP_NOEXCEPT;
+   void waitForProducer( uint32_t timeoutMs ) HOP_NOEXCEPT;
+   // Producer side. Must be called after new data was produced
+   void wakeConsumer() HOP_NOEXCEPT;
+   void addDroppedData( uint32_t threadIndex, uint32_t msgCount, uint32_t traceCount ) HOP_NOEXCEPT;
+   void resetDropCounters() HOP_NOEXCEPT;
    bool valid() const HOP_NOEXCEPT;
    int pid() const HOP_NOEXCEPT;
    const SharedMetaInfo* sharedMetaInfo() const HOP_NOEXCEPT;
@@ -598,8 +722,10 @@ class SharedMemory
   private:
    // Pointer into the shared memory
    SharedMetaInfo* _sharedMetaData{NULL};
+   DropCounters* _dropCounters{NULL};
    ringbuf_t* _ringbuf{NULL};
    uint8_t* _data{NULL};
+   size_t _channelStride{0};
    // ----------------
    bool _isConsumer{false};
    shm_handle _sharedMemHandle{};
@@ -608,6 +734,49 @@ class SharedMemory
    std::atomic<bool> _valid{false};
    std::mutex _creationMutex;
 };
+
+// Variable length encoding of unsigned integers, 7 bits at a time
+inline size_t encodeVarint( uint64_t value, uint8_t* out ) HOP_NOEXCEPT
+{
+   size_t size = 0;
+   while( value >= 0x80 )
+   {
+      out[size++] = static_cast<uint8_t>( value | 0x80 );
+      value >>= 7;
+   }
+   out[size++] = static_cast<uint8_t>( value );
+   return size;
+}
+
+inline size_t decodeVarint( const uint8_t* in, uint64_t* value ) HOP_NOEXCEPT
+{
+   uint64_t result = 0;
+   size_t size     = 0;
+   uint32_t shift  = 0;
+   uint8_t byte;
+   do
+   {
+      byte = in[size++];
+      result |= static_cast<uint64_t>( byte & 0x7F ) << shift;
+      shift += 7;
+   } while( byte & 0x80 );
+   *value = result;
+   return size;
+}
+
+// Map signed values to unsigned ones so small negative values stay small once encoded
+inline uint64_t zigzagEncode( int64_t value ) HOP_NOEXCEPT
+{
+   return ( static_cast<uint64_t>( value ) << 1 ) ^ static_cast<uint64_t>( value >> 63 );
+}
+
+inline int64_t zigzagDecode( uint64_t value ) HOP_NOEXCEPT
+{
+   return static_cast<int64_t>( value >> 1 ) ^ -static_cast<int64_t>( value & 1 );
+}
+
+// Maximum size of a single trace once encoded by encodeTraces
+HOP_CONSTEXPR size_t MAX_ENCODED_TRACE_SIZE = 10 + 10 + 5 + 3 + 3;
 }  // namespace hop
 #endif  // defined(HOP_VIEWER)
 
@@ -621,6 +790,7 @@ class SharedMemory
 #include <algorithm>
 #include <cassert>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -638,6 +808,12 @@ class SharedMemory
 #include <sys/stat.h>  // stat
 #include <unistd.h>    // ftruncate
 
+#if defined( __linux__ )
+#include <linux/futex.h>  // FUTEX_WAIT
+#include <sys/syscall.h>  // SYS_futex
+#include <ctime>          // timespec
+#endif
+
 const HOP_CHAR HOP_SHARED_MEM_PREFIX[] = "/hop_";
 #define HOP_STRLEN( str ) strlen( ( str ) )
 #define HOP_STRNCPYW( dst, src, count ) strncpy( ( dst ), ( src ), ( count ) )
@@ -871,10 +1047,16 @@ SharedMemory::create( int pid, size_t requestedSize, bool isConsumer )
       {
          size_t ringBufSize;
          ringbuf_get_sizes( HOP_MAX_THREAD_NB, &ringBufSize, NULL );
-         totalSize = ringBufSize + requestedSize + sizeof( SharedMetaInfo );
+         const size_t dropCountersSize = HOP_MAX_THREAD_NB * sizeof( DropCounters );
+         totalSize = ringBufSize + requestedSize + sizeof( SharedMetaInfo ) + dropCountersSize;
          sharedMem = reinterpret_cast<uint8_t*>(
              createSharedMemory( _sharedMemPath, totalSize, &_sharedMemHandle, &state ) );
-         if( sharedMem ) new( sharedMem ) SharedMetaInfo;  // Placement new for initializing values
+         if( sharedMem )
+         {
+            // Placement new for initializing values
+            new( sharedMem ) SharedMetaInfo;
+            new( sharedMem + sizeof( SharedMetaInfo ) ) DropCounters[HOP_MAX_THREAD_NB];
+         }
       }
 
       if( !sharedMem )
@@ -892,12 +1074,14 @@ SharedMemory::create( int pid, size_t requestedSize, bool isConsumer )
          metaInfo->maxThreadNb               = HOP_MAX_THREAD_NB;
          metaInfo->requestedSize             = HOP_SHARED_MEM_SIZE;
          metaInfo->usingStdChronoTimeStamps  = HOP_USE_STD_CHRONO;
+         metaInfo->perThreadChannels         = HOP_PER_THREAD_CHANNELS;
+         metaInfo->consumerWakeup            = HOP_CONSUMER_WAKEUP;
          metaInfo->lastResetTimeStamp        = getTimeStamp();
 
          // Take a local copy as we do not want to expose the ring buffer before it is
          // actually initialized
-         ringbuf_t* localRingBuf =
-             reinterpret_cast<ringbuf_t*>( sharedMem + sizeof( SharedMetaInfo ) );
+         ringbuf_t* localRingBuf = reinterpret_cast<ringbuf_t*>(
+             sharedMem + sizeof( SharedMetaInfo ) + HOP_MAX_THREAD_NB * sizeof( DropCounters ) );
 
          // Then setup the ring buffer
          if( ringbuf_setup( localRingBuf, HOP_MAX_THREAD_NB, requestedSize ) < 0 )
@@ -920,14 +1104,35 @@ SharedMemory::create( int pid, size_t requestedSize, bool isConsumer )
          }
       }
 
-      // Get the size needed for the ringbuf struct
+      // Get the size needed for the ringbuf struct and the drop counters
       size_t ringBufSize;
       ringbuf_get_sizes( metaInfo->maxThreadNb, &ringBufSize, NULL );
+      const size_t dropCountersSize = metaInfo->maxThreadNb * sizeof( DropCounters );
 
       // Get pointers inside the shared memory once it has been initialized
-      _sharedMetaData = reinterpret_cast<SharedMetaInfo*>( sharedMem );
-      _ringbuf        = reinterpret_cast<ringbuf_t*>( sharedMem + sizeof( SharedMetaInfo ) );
-      _data           = sharedMem + sizeof( SharedMetaInfo ) + ringBufSize;
+      uint8_t* ringbufPtr = sharedMem + sizeof( SharedMetaInfo ) + dropCountersSize;
+      _sharedMetaData     = reinterpret_cast<SharedMetaInfo*>( sharedMem );
+      _dropCounters       = reinterpret_cast<DropCounters*>( sharedMem + sizeof( SharedMetaInfo ) );
+      _ringbuf            = reinterpret_cast<ringbuf_t*>( ringbufPtr );
+      _data               = ringbufPtr + ringBufSize;
+
+      // When using per-thread channels, the data is evenly split between the threads
+      if( metaInfo->perThreadChannels )
+      {
+         _channelStride = ( metaInfo->requestedSize / metaInfo->maxThreadNb ) & ~size_t( 63 );
+         if( !isConsumer )
+         {
+            for( uint32_t i = 0; i < metaInfo->maxThreadNb; ++i )
+            {
+               if( spscbuf_setup( channel( i ), _channelStride - spscbuf_get_size() ) < 0 )
+               {
+                  assert( false && "Channel creation failed" );
+                  closeSharedMemory( _sharedMemPath, _sharedMemHandle, sharedMem );
+                  return UNKNOWN_CONNECTION_ERROR;
+               }
+            }
+         }
+      }
 
       if( isConsumer )
       {
@@ -1023,6 +1228,95 @@ void SharedMemory::setResetTimestamp( TimeStamp t ) HOP_NOEXCEPT
 
 uint8_t* SharedMemory::data() const HOP_NOEXCEPT { return _data; }
 
+uint32_t SharedMemory::channelCount() const HOP_NOEXCEPT
+{
+   return _channelStride > 0 ? _sharedMetaData->maxThreadNb : 0;
+}
+
+spscbuf_t* SharedMemory::channel( uint32_t threadIndex ) const HOP_NOEXCEPT
+{
+   assert( _channelStride > 0 && threadIndex < _sharedMetaData->maxThreadNb );
+   return reinterpret_cast<spscbuf_t*>( _data + threadIndex * _channelStride );
+}
+
+SharedMemory::DropCounters* SharedMemory::dropCounters() const HOP_NOEXCEPT
+{
+   return _dropCounters;
+}
+
+bool SharedMemory::canParkConsumer() const HOP_NOEXCEPT
+{
+   return _sharedMetaData->consumerWakeup;
+}
+
+void SharedMemory::parkConsumer() HOP_NOEXCEPT
+{
+   _sharedMetaData->consumerParked.store( 1 );
+   // Pairs with the fence in wakeConsumer. Either the consumer sees the newly
+   // produced data, or the producer sees the consumer as parked
+   std::atomic_thread_fence( std::memory_order_seq_cst );
+}
+
+void SharedMemory::unparkConsumer() HOP_NOEXCEPT
+{
+   _sharedMetaData->consumerParked.store( 0, std::memory_order_relaxed );
+}
+
+void SharedMemory::waitForProducer( uint32_t timeoutMs ) HOP_NOEXCEPT
+{
+#if defined( __linux__ )
+   static_assert( sizeof( std::atomic<uint32_t> ) == sizeof( int ), "Invalid futex word" );
+   timespec timeout;
+   timeout.tv_sec  = timeoutMs / 1000;
+   timeout.tv_nsec = ( timeoutMs % 1000 ) * 1000000;
+   // Shared between processes, so the private futex flag cannot be used
+   syscall(
+       SYS_futex,
+       static_cast<void*>( &_sharedMetaData->consumerParked ),
+       FUTEX_WAIT,
+       1,
+       &timeout,
+       NULL,
+       0 );
+#else
+   HOP_SLEEP_MS( timeoutMs );
+#endif
+   unparkConsumer();
+}
+
+void SharedMemory::wakeConsumer() HOP_NOEXCEPT
+{
+#if defined( __linux__ )
+   std::atomic_thread_fence( std::memory_order_seq_cst );
+   std::atomic<uint32_t>& parked = _sharedMetaData->consumerParked;
+   if( parked.load( std::memory_order_relaxed ) && parked.exchange( 0 ) )
+   {
+      syscall( SYS_futex, static_cast<void*>( &parked ), FUTEX_WAKE, 1, NULL, NULL, 0 );
+   }
+#endif
+}
+
+void SharedMemory::addDroppedData(
+    uint32_t threadIndex,
+    uint32_t msgCount,
+    uint32_t traceCount ) HOP_NOEXCEPT
+{
+   if( threadIndex < _sharedMetaData->maxThreadNb )
+   {
+      _dropCounters[threadIndex].droppedMsgCount.fetch_add( msgCount );
+      _dropCounters[threadIndex].droppedTraceCount.fetch_add( traceCount );
+   }
+}
+
+void SharedMemory::resetDropCounters() HOP_NOEXCEPT
+{
+   for( uint32_t i = 0; i < _sharedMetaData->maxThreadNb; ++i )
+   {
+      _dropCounters[i].droppedMsgCount.store( 0 );
+      _dropCounters[i].droppedTraceCount.store( 0 );
+   }
+}
+
 bool SharedMemory::valid() const HOP_NOEXCEPT { return _valid; }
 
 int SharedMemory::pid() const HOP_NOEXCEPT { return _pid; }
@@ -1059,7 +1353,9 @@ void SharedMemory::destroy()
 
       _data           = NULL;
       _ringbuf        = NULL;
+      _dropCounters   = NULL;
       _sharedMetaData = NULL;
+      _channelStride  = 0;
       _valid          = false;
       g_done.store( true );
    }
@@ -1092,9 +1388,7 @@ static void allocTraces( Traces* t, unsigned size )
    t->starts      = (TimeStamp*)realloc( t->starts, size * sizeof( TimeStamp ) );
    t->ends        = (TimeStamp*)realloc( t->ends, size * sizeof( TimeStamp ) );
    t->depths      = (Depth_t*)realloc( t->depths, size * sizeof( Depth_t ) );
-   t->fctNameIds  = (StrPtr_t*)realloc( t->fctNameIds, size * sizeof( StrPtr_t ) );
-   t->fileNameIds = (StrPtr_t*)realloc( t->fileNameIds, size * sizeof( StrPtr_t ) );
-   t->lineNumbers = (LineNb_t*)realloc( t->lineNumbers, size * sizeof( LineNb_t ) );
+   t->callsiteIds = (Callsite_t*)realloc( t->callsiteIds, size * sizeof( Callsite_t ) );
    t->zones       = (ZoneId_t*)realloc( t->zones, size * sizeof( ZoneId_t ) );
 }
 
@@ -1103,9 +1397,7 @@ static void freeTraces( Traces* t )
    free( t->starts );
    free( t->ends );
    free( t->depths );
-   free( t->fctNameIds );
-   free( t->fileNameIds );
-   free( t->lineNumbers );
+   free( t->callsiteIds );
    free( t->zones );
    memset( t, 0, sizeof( Traces ) );
 }
@@ -1115,9 +1407,7 @@ static void addTrace(
     TimeStamp start,
     TimeStamp end,
     Depth_t depth,
-    StrPtr_t fileName,
-    StrPtr_t fctName,
-    LineNb_t lineNb,
+    Callsite_t callsite,
     ZoneId_t zone )
 {
    const uint32_t curCount = t->count;
@@ -1129,51 +1419,83 @@ static void addTrace(
    t->starts[curCount]      = start;
    t->ends[curCount]        = end;
    t->depths[curCount]      = depth;
-   t->fileNameIds[curCount] = fileName;
-   t->fctNameIds[curCount]  = fctName;
-   t->lineNumbers[curCount] = lineNb;
+   t->callsiteIds[curCount] = callsite;
    t->zones[curCount]       = zone;
    ++t->count;
 }
 
-static size_t traceDataSize( const Traces* t )
-{
-   const size_t sliceSize = sizeof( TimeStamp ) * 2 + +sizeof( Depth_t ) + sizeof( StrPtr_t ) * 2 +
-                            sizeof( LineNb_t ) + sizeof( ZoneId_t );
-   return sliceSize * t->count;
+static HOP_CONSTEXPR size_t TRACE_SLICE_SIZE = sizeof( TimeStamp ) * 2 + sizeof( Depth_t ) +
+                                               sizeof( StrPtr_t ) * 2 + sizeof( LineNb_t ) +
+                                               sizeof( ZoneId_t );
+
+// Encode the traces using the COMPACT_V1 encoding. Each trace is written as the varints of
+//    - the zigzag delta between its end time and the previous trace end time
+//    - the zigzag delta between its end and start time (keeps the dynamic string flag of start)
+//    - its callsite id
+//    - its depth
+//    - its zone
+// The out buffer must hold at least MAX_ENCODED_TRACE_SIZE * t->count bytes.
+// Returns the number of bytes written.
+static size_t encodeTraces( const Traces* t, uint8_t* outBuffer )
+{
+   uint8_t* out      = outBuffer;
+   TimeStamp prevEnd = 0;
+   for( uint32_t i = 0; i < t->count; ++i )
+   {
+      const TimeStamp end = t->ends[i];
+      out += encodeVarint( zigzagEncode( (int64_t)( end - prevEnd ) ), out );
+      out += encodeVarint( zigzagEncode( (int64_t)( end - t->starts[i] ) ), out );
+      out += encodeVarint( t->callsiteIds[i], out );
+      out += encodeVarint( t->depths[i], out );
+      out += encodeVarint( t->zones[i], out );
+      prevEnd = end;
+   }
+   return out - outBuffer;
 }
 
-static void copyTracesTo( const Traces* t, void* outBuffer )
+// Dynamic callsites are derived from the callsite of the HOP_PROF_DYN_NAME
+// macro and the hash of the dynamic string
+struct DynCallsiteKey
 {
-   const uint32_t count = t->count;
-
-   void* startsPtr         = outBuffer;
-   const size_t startsSize = sizeof( t->starts[0] ) * count;
-   memcpy( startsPtr, t->starts, startsSize );
-
-   void* endsPtr         = (uint8_t*)startsPtr + startsSize;
-   const size_t endsSize = sizeof( t->ends[0] ) * count;
-   memcpy( endsPtr, t->ends, endsSize );
-
-   void* fileNamesPtr         = (uint8_t*)endsPtr + endsSize;
-   const size_t fileNamesSize = sizeof( t->fileNameIds[0] ) * count;
-   memcpy( fileNamesPtr, t->fileNameIds, fileNamesSize );
+   Callsite_t callsite;
+   StrPtr_t fctName;
+   bool operator==( const DynCallsiteKey& rhs ) const
+   {
+      return callsite == rhs.callsite && fctName == rhs.fctName;
+   }
+};
 
-   void* fctNamesPtr         = (uint8_t*)fileNamesPtr + fileNamesSize;
-   const size_t fctNamesSize = sizeof( t->fctNameIds[0] ) * count;
-   memcpy( fctNamesPtr, t->fctNameIds, fctNamesSize );
+struct DynCallsiteKeyHash
+{
+   size_t operator()( const DynCallsiteKey& key ) const
+   {
+      size_t h = std::hash<StrPtr_t>()( key.fctName );
+      h ^= std::hash<Callsite_t>()( key.callsite ) + 0x9e3779b9 + ( h << 6 ) + ( h >> 2 );
+      return h;
+   }
+};
 
-   void* lineNbPtr         = (uint8_t*)fctNamesPtr + fctNamesSize;
-   const size_t lineNbSize = sizeof( t->lineNumbers[0] ) * count;
-   memcpy( lineNbPtr, t->lineNumbers, lineNbSize );
+// Callsites shared by all the threads of the process. The callsite id is the
+// index in the callsites array.
+struct CallsiteRegistry
+{
+   struct Entry
+   {
+      StrPtr_t fileName;
+      StrPtr_t fctName;
+      LineNb_t lineNb;
+      bool dynamicName;  // Function name is the hash of a dynamic string
+   };
 
-   void* depthsPtr         = (uint8_t*)lineNbPtr + lineNbSize;
-   const size_t depthsSize = sizeof( t->depths[0] ) * count;
-   memcpy( depthsPtr, t->depths, depthsSize );
+   std::mutex mutex;
+   std::vector<Entry> callsites;
+   std::unordered_map<DynCallsiteKey, Callsite_t, DynCallsiteKeyHash> dynCallsites;
+};
 
-   void* zonesPtr        = (uint8_t*)depthsPtr + depthsSize;
-   const size_t zoneSize = sizeof( t->zones[0] ) * count;
-   memcpy( zonesPtr, t->zones, zoneSize );
+static CallsiteRegistry& callsiteRegistry()
+{
+   HOP_NO_DESTROY static CallsiteRegistry registry;
+   return registry;
 }
 
 class Client
@@ -1191,19 +1513,40 @@ class Client
       _stringData.reserve( 256 * 32 );
 
       resetStringData();
+      _lastFlushTimeStamp = getTimeStamp();
    }
 
    ~Client() { freeTraces( &_traces ); }
 
-   void addProfilingTrace(
-       StrPtr_t fileName,
-       StrPtr_t fctName,
-       TimeStamp start,
-       TimeStamp end,
-       LineNb_t lineNb,
-       ZoneId_t zone )
+   void addProfilingTrace( Callsite_t callsite, TimeStamp start, TimeStamp end, ZoneId_t zone )
+   {
+      addTrace( &_traces, start, end, (Depth_t)tl_traceLevel, callsite, zone );
+   }
+
+   Callsite_t dynamicCallsite( Callsite_t callsite, StrPtr_t fctName )
    {
-      addTrace( &_traces, start, end, (Depth_t)tl_traceLevel, fileName, fctName, lineNb, zone );
+      const DynCallsiteKey key = {callsite, fctName};
+      auto it                  = _dynCallsites.find( key );
+      if( it != _dynCallsites.end() ) return it->second;
+
+      Callsite_t dynCallsite;
+      {
+         CallsiteRegistry& registry = callsiteRegistry();
+         std::lock_guard<std::mutex> guard( registry.mutex );
+         auto res = registry.dynCallsites.emplace(
+             key, static_cast<Callsite_t>( registry.callsites.size() ) );
+         if( res.second )
+         {
+            CallsiteRegistry::Entry entry = registry.callsites[callsite];
+            entry.fctName                 = fctName;
+            entry.dynamicName             = true;
+            registry.callsites.push_back( entry );
+         }
+         dynCallsite = res.first->second;
+      }
+
+      _dynCallsites.emplace( key, dynCallsite );
+      return dynCallsite;
    }
 
    void addCoreEvent( Core_t core, TimeStamp startTime, TimeStamp endTime )
@@ -1293,7 +1636,9 @@ class Client
    {
       _stringPtr.clear();
       _stringData.clear();
-      _sentStringDataSize   = 0;
+      _sentStringDataSize = 0;
+      _callsitesSent.clear();
+      _newCallsites.clear();
       _clientResetTimeStamp = ClientManager::sharedMemory().lastResetTimestamp();
 
       // Push back thread name
@@ -1313,95 +1658,215 @@ class Client
       _unlockEvents.clear();
    }
 
-   uint8_t* acquireSharedChunk( ringbuf_t* ringbuf, size_t size )
+   ssize_t tryAcquireSharedChunk( size_t paddedSize )
+   {
+#if HOP_PER_THREAD_CHANNELS
+      return spscbuf_acquire( _channel, paddedSize );
+#else
+      return ringbuf_acquire( ClientManager::sharedMemory().ringbuffer(), _worker, paddedSize );
+#endif
+   }
+
+   uint8_t* acquireSharedChunk( size_t size )
    {
       uint8_t* data          = NULL;
-      const bool msgWayToBig = size > HOP_SHARED_MEM_SIZE;
+      const bool msgWayToBig = size > _maxMsgSize;
       if( !msgWayToBig )
       {
          const size_t paddedSize = alignOn( static_cast<uint32_t>( size ), 8 );
-         const ssize_t offset    = ringbuf_acquire( ringbuf, _worker, paddedSize );
+         ssize_t offset          = tryAcquireSharedChunk( paddedSize );
+#if HOP_FULL_BUFFER_POLICY == HOP_FULL_BUFFER_SPIN
+         // Give some time to the viewer to consume the ring buffer before giving up
+         if( offset == -1 )
+         {
+            const TimeStamp spinStart = getTimeStamp();
+            do
+            {
+               offset = tryAcquireSharedChunk( paddedSize );
+            } while( offset == -1 && getTimeStamp() - spinStart < HOP_MAX_SPIN_WAIT_CYCLES );
+         }
+#endif
          if( offset != -1 )
          {
-            data = &ClientManager::sharedMemory().data()[offset];
+            data = &_sharedData[offset];
          }
       }
 
       return data;
    }
 
-   bool sendStringData( TimeStamp timeStamp )
+   void produceSharedChunk()
+   {
+#if HOP_PER_THREAD_CHANNELS
+      spscbuf_produce( _channel );
+#else
+      ringbuf_produce( ClientManager::sharedMemory().ringbuffer(), _worker );
+#endif
+#if HOP_CONSUMER_WAKEUP
+      ClientManager::sharedMemory().wakeConsumer();
+#endif
+   }
+
+   // Called when a message of msgSize bytes could not be written in the ring
+   // buffer. Returns whether the pending data should be dropped according to
+   // HOP_FULL_BUFFER_POLICY. Dropped data is reported to the viewer.
+   bool dropOnFullBuffer( size_t msgSize, uint32_t traceCount )
+   {
+      const bool canNeverFit = msgSize > _maxMsgSize;
+      if( HOP_FULL_BUFFER_POLICY == HOP_FULL_BUFFER_RETRY && !canNeverFit ) return false;
+
+      if( !_dropReported )
+      {
+         printf(
+             "HOP - Failed to acquire enough shared memory. Data from thread %u will be "
+             "dropped. Consider increasing shared memory size\n",
+             tl_threadIndex );
+         _dropReported = true;
+      }
+      ClientManager::sharedMemory().addDroppedData( tl_threadIndex, 1, traceCount );
+      return true;
+   }
+
+   // Queue the information of the callsites that were never sent by this
+   // thread, and add their strings to the database
+   void addNewCallsites()
    {
-      // Add all strings to the database
       for( uint32_t i = 0; i < _traces.count; ++i )
       {
-         addStringToDb( _traces.fileNameIds[i] );
+         const Callsite_t id = _traces.callsiteIds[i];
+         if( id < _callsitesSent.size() && _callsitesSent[id] ) continue;
 
-         // String that were added dynamically are already in the
-         // database and are flaged with the first bit of their start
-         // time being 1. Therefore we only need to add the
-         // non-dynamic strings. (first bit of start time being 0)
-         if( ( _traces.starts[i] & 1 ) == 0 ) addStringToDb( _traces.fctNameIds[i] );
-      }
+         if( id >= _callsitesSent.size() ) _callsitesSent.resize( id + 1, false );
+         _callsitesSent[id] = true;
 
-      const uint32_t stringDataSize = static_cast<uint32_t>( _stringData.size() );
-      assert( stringDataSize >= _sentStringDataSize );
-      const uint32_t stringToSendSize = stringDataSize - _sentStringDataSize;
-      const size_t msgSize            = sizeof( MsgInfo ) + stringToSendSize;
+         CallsiteRegistry::Entry callsite;
+         {
+            CallsiteRegistry& registry = callsiteRegistry();
+            std::lock_guard<std::mutex> guard( registry.mutex );
+            callsite = registry.callsites[id];
+         }
 
-      ringbuf_t* ringbuf = ClientManager::sharedMemory().ringbuffer();
-      uint8_t* bufferPtr = acquireSharedChunk( ringbuf, msgSize );
+         addStringToDb( callsite.fileName );
 
-      if( !bufferPtr )
-      {
-         printf(
-             "HOP - String to send are bigger than shared memory size. Consider"
-             " increasing shared memory size \n" );
-         return false;
+         // String that were added dynamically are already in the database
+         if( !callsite.dynamicName ) addStringToDb( callsite.fctName );
+
+         _newCallsites.push_back(
+             CallsiteInfo{callsite.fileName, callsite.fctName, callsite.lineNb, id} );
       }
+   }
+
+   // Size of the entry of the string data starting at pos
+   size_t stringEntrySize( size_t pos ) const
+   {
+      const char* str = &_stringData[pos + sizeof( StrPtr_t )];
+      return sizeof( StrPtr_t ) + alignOn( static_cast<uint32_t>( strlen( str ) ) + 1, 8 );
+   }
+
+   // Acquire a string data message with room for dataSize bytes of strings.
+   // Returns a pointer to the strings of the message, or NULL if it did not fit.
+   char* acquireStringDataMsg( TimeStamp timeStamp, size_t dataSize )
+   {
+      uint8_t* bufferPtr = acquireSharedChunk( sizeof( MsgInfo ) + dataSize );
+      if( !bufferPtr ) return NULL;
+
+      // The data layout is as follow:
+      // =========================================================
+      // msgInfo     = Profiler specific infos  - Information about the message sent
+      // stringData  = String Data              - Array with all strings referenced by the traces
+      MsgInfo* msgInfo         = reinterpret_cast<MsgInfo*>( bufferPtr );
+      msgInfo->type            = MsgType::PROFILER_STRING_DATA;
+      msgInfo->threadId        = tl_threadId;
+      msgInfo->threadName      = tl_threadName;
+      msgInfo->threadIndex     = tl_threadIndex;
+      msgInfo->timeStamp       = timeStamp;
+      msgInfo->stringData.size = static_cast<uint32_t>( dataSize );
+      return reinterpret_cast<char*>( bufferPtr + sizeof( MsgInfo ) );
+   }
+
+   // Send the strings that were not sent yet. On failure, failedMsgSize is set to
+   // the size of the message that could not be acquired.
+   bool sendStringData( TimeStamp timeStamp, size_t* failedMsgSize )
+   {
+      addNewCallsites();
 
-      // Fill the buffer with the string data
+      const size_t stringDataSize = _stringData.size();
+      assert( stringDataSize >= _sentStringDataSize );
+
+      // The strings are split in as many messages as needed for each of them to fit
+      // in the shared memory, keeping room for the other messages like the traces
+      // do. A message only holds whole entries, as the viewer parses each of them
+      // on its own.
+      const size_t maxDataSize = _maxMsgSize / 2 - sizeof( MsgInfo );
+      while( _sentStringDataSize < stringDataSize )
       {
-         // The data layout is as follow:
-         // =========================================================
-         // msgInfo     = Profiler specific infos  - Information about the message sent
-         // stringData  = String Data              - Array with all strings referenced by the traces
-         MsgInfo* msgInfo = reinterpret_cast<MsgInfo*>( bufferPtr );
-         char* stringData = reinterpret_cast<char*>( bufferPtr + sizeof( MsgInfo ) );
+         size_t end = _sentStringDataSize;
+         while( end < stringDataSize && end + stringEntrySize( end ) - _sentStringDataSize <= maxDataSize )
+         {
+            end += stringEntrySize( end );
+         }
+
+         if( end == _sentStringDataSize )
+         {
+            // This string alone can never fit. Send it truncated so the traces
+            // referencing it remain valid, and report it as dropped data.
+            const size_t truncatedSize = ( maxDataSize - sizeof( StrPtr_t ) ) & ~size_t( 7 );
+            char* stringData = acquireStringDataMsg( timeStamp, sizeof( StrPtr_t ) + truncatedSize );
+            if( !stringData )
+            {
+               *failedMsgSize = sizeof( MsgInfo ) + sizeof( StrPtr_t ) + truncatedSize;
+               return false;
+            }
+            memcpy( stringData, &_stringData[_sentStringDataSize], sizeof( StrPtr_t ) + truncatedSize );
+            stringData[sizeof( StrPtr_t ) + truncatedSize - 1] = '\0';
+            produceSharedChunk();
+            ClientManager::sharedMemory().addDroppedData( tl_threadIndex, 1, 0 );
+
+            _sentStringDataSize += static_cast<uint32_t>( stringEntrySize( _sentStringDataSize ) );
+            continue;
+         }
 
-         msgInfo->type            = MsgType::PROFILER_STRING_DATA;
-         msgInfo->threadId        = tl_threadId;
-         msgInfo->threadName      = tl_threadName;
-         msgInfo->threadIndex     = tl_threadIndex;
-         msgInfo->timeStamp       = timeStamp;
-         msgInfo->stringData.size = stringToSendSize;
+         // The string data is never dropped, as the traces depend on it. The
+         // strings that were not sent will simply be part of the next message.
+         const size_t dataSize = end - _sentStringDataSize;
+         char* stringData      = acquireStringDataMsg( timeStamp, dataSize );
+         if( !stringData )
+         {
+            *failedMsgSize = sizeof( MsgInfo ) + dataSize;
+            return false;
+         }
 
          // Copy string data into its array
          const auto itFrom = _stringData.begin() + _sentStringDataSize;
-         std::copy( itFrom, itFrom + stringToSendSize, stringData );
-      }
+         std::copy( itFrom, itFrom + dataSize, stringData );
+         produceSharedChunk();
 
-      ringbuf_produce( ringbuf, _worker );
-
-      // Update sent array size
-      _sentStringDataSize = stringDataSize;
+         // Update sent array size
+         _sentStringDataSize = static_cast<uint32_t>( end );
+      }
 
       return true;
    }
 
    bool sendTraces( TimeStamp timeStamp )
    {
+      if( _traces.count == 0 ) return false;
+
+      // Encode the traces before acquiring the shared memory so that we only
+      // reserve what is needed
+      _encodedTraces.resize( MAX_ENCODED_TRACE_SIZE * _traces.count );
+      const size_t encodedSize = encodeTraces( &_traces, _encodedTraces.data() );
+
       // Get size of profiling traces message
-      const size_t profilerMsgSize = sizeof( MsgInfo ) + traceDataSize( &_traces );
+      const size_t callsitesSize   = _newCallsites.size() * sizeof( CallsiteInfo );
+      const size_t profilerMsgSize =
+          sizeof( MsgInfo ) + sizeof( CompactTracesHeader ) + callsitesSize + encodedSize;
 
-      ringbuf_t* ringbuf = ClientManager::sharedMemory().ringbuffer();
-      uint8_t* bufferPtr = acquireSharedChunk( ringbuf, profilerMsgSize );
+      uint8_t* bufferPtr = acquireSharedChunk( profilerMsgSize );
       if( !bufferPtr )
       {
-         printf(
-             "HOP - Failed to acquire enough shared memory. Consider increasing"
-             "shared memory size if you see this message more than once\n" );
-         _traces.count = 0;
+         // The new callsites stay pending so they can be sent with the next traces
+         if( dropOnFullBuffer( profilerMsgSize, _traces.count ) ) _traces.count = 0;
          return false;
       }
 
@@ -1410,24 +1875,35 @@ class Client
          // The data layout is as follow:
          // =========================================================
          // msgInfo     = Profiler specific infos  - Information about the message sent
-         // traceToSend = Traces                   - Array containing all of the traces
+         // header      = CompactTracesHeader      - Size of the following arrays
+         // callsites   = CallsiteInfo             - Callsites used for the first time
+         // traceToSend = Encoded traces           - See encodeTraces
          MsgInfo* tracesInfo = reinterpret_cast<MsgInfo*>( bufferPtr );
 
-         tracesInfo->type         = MsgType::PROFILER_TRACE;
-         tracesInfo->threadId     = tl_threadId;
-         tracesInfo->threadName   = tl_threadName;
-         tracesInfo->threadIndex  = tl_threadIndex;
-         tracesInfo->timeStamp    = timeStamp;
-         tracesInfo->traces.count = _traces.count;
+         tracesInfo->type            = MsgType::PROFILER_TRACE;
+         tracesInfo->threadId        = tl_threadId;
+         tracesInfo->threadName      = tl_threadName;
+         tracesInfo->threadIndex     = tl_threadIndex;
+         tracesInfo->timeStamp       = timeStamp;
+         tracesInfo->traces.count    = _traces.count;
+         tracesInfo->traces.encoding = TraceEncoding::COMPACT_V1;
+         bufferPtr += sizeof( MsgInfo );
+
+         CompactTracesHeader* header = reinterpret_cast<CompactTracesHeader*>( bufferPtr );
+         header->newCallsiteCount    = static_cast<uint32_t>( _newCallsites.size() );
+         header->encodedSize         = static_cast<uint32_t>( encodedSize );
+         bufferPtr += sizeof( CompactTracesHeader );
 
-         // Copy trace information into buffer to send
-         void* outBuffer = (void*)( bufferPtr + sizeof( MsgInfo ) );
-         copyTracesTo( &_traces, outBuffer );
+         memcpy( bufferPtr, _newCallsites.data(), callsitesSize );
+         bufferPtr += callsitesSize;
+
+         memcpy( bufferPtr, _encodedTraces.data(), encodedSize );
       }
 
-      ringbuf_produce( ringbuf, _worker );
+      produceSharedChunk();
 
       _traces.count = 0;
+      _newCallsites.clear();
 
       return true;
    }
@@ -1438,14 +1914,10 @@ class Client
 
       const size_t coreMsgSize = sizeof( MsgInfo ) + _cores.size() * sizeof( CoreEvent );
 
-      ringbuf_t* ringbuf = ClientManager::sharedMemory().ringbuffer();
-      uint8_t* bufferPtr = acquireSharedChunk( ringbuf, coreMsgSize );
+      uint8_t* bufferPtr = acquireSharedChunk( coreMsgSize );
       if( !bufferPtr )
       {
-         printf(
-             "HOP - Failed to acquire enough shared memory. Consider increasing shared memory "
-             "size\n" );
-         _cores.clear();
+         if( dropOnFullBuffer( coreMsgSize, 0 ) ) _cores.clear();
          return false;
       }
 
@@ -1462,7 +1934,7 @@ class Client
          memcpy( bufferPtr, _cores.data(), _cores.size() * sizeof( CoreEvent ) );
       }
 
-      ringbuf_produce( ringbuf, _worker );
+      produceSharedChunk();
 
       const auto lastEntry = _cores.back();
       _cores.clear();
@@ -1477,14 +1949,10 @@ class Client
 
       const size_t lockMsgSize = sizeof( MsgInfo ) + _lockWaits.size() * sizeof( LockWait );
 
-      ringbuf_t* ringbuf = ClientManager::sharedMemory().ringbuffer();
-      uint8_t* bufferPtr = acquireSharedChunk( ringbuf, lockMsgSize );
+      uint8_t* bufferPtr = acquireSharedChunk( lockMsgSize );
       if( !bufferPtr )
       {
-         printf(
-             "HOP - Failed to acquire enough shared memory. Consider increasing shared memory "
-             "size\n" );
-         _lockWaits.clear();
+         if( dropOnFullBuffer( lockMsgSize, 0 ) ) _lockWaits.clear();
          return false;
       }
 
@@ -1501,7 +1969,7 @@ class Client
          memcpy( bufferPtr, _lockWaits.data(), _lockWaits.size() * sizeof( LockWait ) );
       }
 
-      ringbuf_produce( ringbuf, _worker );
+      produceSharedChunk();
 
       _lockWaits.clear();
 
@@ -1515,14 +1983,10 @@ class Client
       const size_t unlocksMsgSize =
           sizeof( MsgInfo ) + _unlockEvents.size() * sizeof( UnlockEvent );
 
-      ringbuf_t* ringbuf = ClientManager::sharedMemory().ringbuffer();
-      uint8_t* bufferPtr = acquireSharedChunk( ringbuf, unlocksMsgSize );
+      uint8_t* bufferPtr = acquireSharedChunk( unlocksMsgSize );
       if( !bufferPtr )
       {
-         printf(
-             "HOP - Failed to acquire enough shared memory. Consider increasing shared memory "
-             "size\n" );
-         _unlockEvents.clear();
+         if( dropOnFullBuffer( unlocksMsgSize, 0 ) ) _unlockEvents.clear();
          return false;
       }
 
@@ -1539,7 +2003,7 @@ class Client
          memcpy( bufferPtr, _unlockEvents.data(), _unlockEvents.size() * sizeof( UnlockEvent ) );
       }
 
-      ringbuf_produce( ringbuf, _worker );
+      produceSharedChunk();
 
       _unlockEvents.clear();
 
@@ -1552,15 +2016,9 @@ class Client
 
       const size_t heartbeatSize = sizeof( MsgInfo );
 
-      ringbuf_t* ringbuf = ClientManager::sharedMemory().ringbuffer();
-      uint8_t* bufferPtr = acquireSharedChunk( ringbuf, heartbeatSize );
-      if( !bufferPtr )
-      {
-         printf(
-             "HOP - Failed to acquire enough shared memory. Consider increasing shared memory "
-             "size\n" );
-         return false;
-      }
+      uint8_t* bufferPtr = acquireSharedChunk( heartbeatSize );
+      // Nothing to drop, another heartbeat will be sent later
+      if( !bufferPtr ) return false;
 
       // Fill the buffer with the lock message
       {
@@ -1573,14 +2031,26 @@ class Client
          bufferPtr += sizeof( MsgInfo );
       }
 
-      ringbuf_produce( ringbuf, _worker );
+      produceSharedChunk();
 
       return true;
    }
 
+   // Check if the pending traces should be flushed even though the thread is
+   // still inside a trace
+   bool shouldFlushNested( TimeStamp timeStamp ) const
+   {
+      const bool tooManyTraces = _traces.count >= _maxPendingTraces;
+      const bool tooLongSinceFlush =
+          HOP_MAX_FLUSH_INTERVAL > 0 &&
+          (TimeDuration)( timeStamp - _lastFlushTimeStamp ) > HOP_MAX_FLUSH_INTERVAL;
+      return tooManyTraces || tooLongSinceFlush;
+   }
+
    void flushToConsumer()
    {
       const TimeStamp timeStamp = getTimeStamp();
+      _lastFlushTimeStamp       = timeStamp;
 
       // If we have a consumer, send life signal
       if( ClientManager::HasConnectedConsumer() && ClientManager::ShouldSendHeartbeat( timeStamp ) )
@@ -1604,8 +2074,19 @@ class Client
             return;
          }
 
-         sendStringData( timeStamp );  // Always send string data first
-         sendTraces( timeStamp );
+         // Always send string data first. If it could not be sent, the traces
+         // referencing it cannot be sent either, and are kept or dropped according
+         // to the policy. As every string message fits in the shared memory, the
+         // traces are never kept forever waiting on the strings.
+         size_t failedStringMsgSize = 0;
+         if( sendStringData( timeStamp, &failedStringMsgSize ) )
+         {
+            sendTraces( timeStamp );
+         }
+         else if( _traces.count > 0 && dropOnFullBuffer( failedStringMsgSize, _traces.count ) )
+         {
+            _traces.count = 0;
+         }
          sendLockWaits( timeStamp );
          sendUnlockEvents( timeStamp );
          sendCores( timeStamp );
@@ -1622,9 +2103,20 @@ class Client
    std::vector<UnlockEvent> _unlockEvents;
    std::unordered_set<StrPtr_t> _stringPtr;
    std::vector<char> _stringData;
+
+   std::unordered_map<DynCallsiteKey, Callsite_t, DynCallsiteKeyHash> _dynCallsites;
+   std::vector<bool> _callsitesSent;         // Callsites already received by the viewer
+   std::vector<CallsiteInfo> _newCallsites;  // Callsites to send with the next traces
+   std::vector<uint8_t> _encodedTraces;
    TimeStamp _clientResetTimeStamp{0};
+   TimeStamp _lastFlushTimeStamp{0};
    ringbuf_worker_t* _worker{NULL};
+   spscbuf_t* _channel{NULL};
+   uint8_t* _sharedData{NULL};        // Start of the shared memory our messages are written to
+   size_t _maxMsgSize{0};             // Biggest message that can fit in the shared memory
+   uint32_t _maxPendingTraces{0};     // Pending traces count that triggers a flush
    uint32_t _sentStringDataSize{0};  // The size of the string array on viewer side
+   bool _dropReported{false};
 };
 
 Client* ClientManager::Get()
@@ -1654,50 +2146,79 @@ Client* ClientManager::Get()
    tl_threadIndex = threadCount.fetch_add( 1 );
    tl_threadId    = HOP_GET_THREAD_ID();
 
-   if( tl_threadIndex > HOP_MAX_THREAD_NB )
+   if( tl_threadIndex >= HOP_MAX_THREAD_NB )
    {
       printf( "Maximum number of threads reached. No trace will be available for this thread\n" );
       return nullptr;
    }
 
-   // Register producer in the ringbuffer
-   auto ringBuffer = ClientManager::sharedMemory().ringbuffer();
+   // Register producer in the ringbuffer, or get the thread's own channel
+   SharedMemory& sharedMem = ClientManager::sharedMemory();
+   auto ringBuffer         = sharedMem.ringbuffer();
    if( ringBuffer )
    {
-      threadClient.reset( new Client() );
-      threadClient->_worker = ringbuf_register( ringBuffer, tl_threadIndex );
-      if( threadClient->_worker == NULL )
+      Client* client = new Client();
+      threadClient.reset( client );
+#if HOP_PER_THREAD_CHANNELS
+      client->_channel    = sharedMem.channel( tl_threadIndex );
+      client->_sharedData = spscbuf_data( client->_channel );
+      client->_maxMsgSize = spscbuf_space( client->_channel );
+#else
+      client->_worker = ringbuf_register( ringBuffer, tl_threadIndex );
+      if( client->_worker == NULL )
       {
          assert( false && "ringbuf_register" );
       }
+      client->_sharedData = sharedMem.data();
+      client->_maxMsgSize = HOP_SHARED_MEM_SIZE;
+#endif
+
+      // Flush the pending traces before they get too big to be sent, keeping
+      // room for the other messages
+      const size_t maxTracesPerMsg = client->_maxMsgSize / ( 2 * TRACE_SLICE_SIZE );
+      const size_t maxPending = HOP_MAX_PENDING_TRACES > 0 ? HOP_MAX_PENDING_TRACES : UINT32_MAX;
+      client->_maxPendingTraces = static_cast<uint32_t>( HOP_MIN( maxPending, maxTracesPerMsg ) );
    }
 
    return threadClient.get();
 }
 
+Callsite_t ClientManager::RegisterCallsite(
+    const char* fileName,
+    LineNb_t lineNb,
+    const char* fctName )
+{
+   CallsiteRegistry& registry = callsiteRegistry();
+   std::lock_guard<std::mutex> guard( registry.mutex );
+   registry.callsites.push_back( CallsiteRegistry::Entry{reinterpret_cast<StrPtr_t>( fileName ),
+                                                         reinterpret_cast<StrPtr_t>( fctName ),
+                                                         lineNb,
+                                                         false} );
+   return static_cast<Callsite_t>( registry.callsites.size() - 1 );
+}
+
 ZoneId_t ClientManager::StartProfile()
 {
    ++tl_traceLevel;
    return tl_zoneId;
 }
 
-StrPtr_t ClientManager::StartProfileDynString( const char* str, ZoneId_t* zone )
+Callsite_t
+ClientManager::StartProfileDynString( Callsite_t callsite, const char* str, ZoneId_t* zone )
 {
    ++tl_traceLevel;
    Client* client = ClientManager::Get();
 
-   if( unlikely( !client ) ) return 0;
+   if( unlikely( !client ) ) return callsite;
 
    *zone = tl_zoneId;
-   return client->addDynamicStringToDb( str );
+   return client->dynamicCallsite( callsite, client->addDynamicStringToDb( str ) );
 }
 
 void ClientManager::EndProfile(
-    StrPtr_t fileName,
-    StrPtr_t fctName,
+    Callsite_t callsite,
     TimeStamp start,
     TimeStamp end,
-    LineNb_t lineNb,
     ZoneId_t zone,
     Core_t core )
 {
@@ -1708,10 +2229,12 @@ void ClientManager::EndProfile(
 
    if( end - start > 50 )  // Minimum trace time is 50 ns
    {
-      client->addProfilingTrace( fileName, fctName, start, end, lineNb, zone );
+      client->addProfilingTrace( callsite, start, end, zone );
       client->addCoreEvent( core, start, end );
    }
-   if( remainingPushedTraces <= 0 )
+   // Flush when leaving the outermost trace, or earlier if the thread has been
+   // nested for too long so the viewer still receives its traces
+   if( remainingPushedTraces <= 0 || client->shouldFlushNested( end ) )
    {
       client->flushToConsumer();
    }
@@ -2173,6 +2696,142 @@ void ringbuf_release( ringbuf_t* rbuf, size_t nbytes )
    rbuf->written = ( nwritten == rbuf->space ) ? 0 : nwritten;
 }
 
+/*
+ * Single producer single consumer ring buffer used for the per-thread channels.
+ * The 'produced' and 'consumed' offsets are ever increasing and only written by
+ * their respective side, so the producer never needs an atomic read-modify-write.
+ * Since messages must be contiguous, a message that does not fit at the end of
+ * the buffer is written at its beginning. The 'end' offset then tells the
+ * consumer where the data stopped before wrapping around.
+ */
+struct spscbuf
+{
+   /* Ring buffer space. Set once at creation. */
+   size_t space;
+
+   /* The following are only updated by the producer. */
+   ringbuf_off_t next;
+   ringbuf_off_t end;
+   uint8_t producerPadding[64 - sizeof( size_t ) - 2 * sizeof( ringbuf_off_t )];
+   std::atomic<ringbuf_off_t> produced;
+   uint8_t producedPadding[64 - sizeof( std::atomic<ringbuf_off_t> )];
+
+   /* The following is only updated by the consumer. */
+   std::atomic<ringbuf_off_t> consumed;
+   uint8_t consumedPadding[64 - sizeof( std::atomic<ringbuf_off_t> )];
+};
+
+size_t spscbuf_get_size() { return sizeof( spscbuf_t ); }
+
+/*
+ * spscbuf_setup: initialise a new ring buffer of a given length. The data
+ * directly follows the spscbuf_t structure.
+ */
+int spscbuf_setup( spscbuf_t* sbuf, size_t length )
+{
+   if( length == 0 || length >= RBUF_OFF_MASK )
+   {
+      return -1;
+   }
+   sbuf->space = length & ~size_t( 7 );
+   sbuf->next  = 0;
+   sbuf->end   = sbuf->space;
+   sbuf->produced.store( 0 );
+   sbuf->consumed.store( 0 );
+   return 0;
+}
+
+size_t spscbuf_space( const spscbuf_t* sbuf ) { return sbuf->space; }
+
+uint8_t* spscbuf_data( spscbuf_t* sbuf ) { return reinterpret_cast<uint8_t*>( sbuf + 1 ); }
+
+/*
+ * spscbuf_acquire: request a contiguous space of a given length.
+ *
+ * => On success: returns the offset at which the space is available.
+ * => On failure: returns -1.
+ */
+ssize_t spscbuf_acquire( spscbuf_t* sbuf, size_t len )
+{
+   assert( len > 0 && len <= sbuf->space );
+
+   const ringbuf_off_t produced = sbuf->produced.load( std::memory_order_relaxed );
+   const size_t offset          = produced % sbuf->space;
+
+   /* Skip the end of the buffer if the message cannot fit in it. */
+   const size_t skipped        = offset + len > sbuf->space ? sbuf->space - offset : 0;
+   const ringbuf_off_t target  = produced + skipped + len;
+   if( target - sbuf->consumed.load( std::memory_order_acquire ) > sbuf->space )
+   {
+      /* The consumer is lagging behind. */
+      return -1;
+   }
+
+   /* Let the consumer know where the data stops when wrapping around. */
+   if( skipped > 0 )
+   {
+      sbuf->end = offset;
+   }
+   else if( offset + len == sbuf->space )
+   {
+      sbuf->end = sbuf->space;
+   }
+
+   sbuf->next = target;
+   return skipped > 0 ? 0 : offset;
+}
+
+/*
+ * spscbuf_produce: indicate the acquired range is ready to be consumed.
+ */
+void spscbuf_produce( spscbuf_t* sbuf )
+{
+   sbuf->produced.store( sbuf->next, std::memory_order_release );
+}
+
+/*
+ * spscbuf_consume: get a contiguous range which is ready to be consumed.
+ */
+size_t spscbuf_consume( spscbuf_t* sbuf, size_t* offset )
+{
+   const ringbuf_off_t produced = sbuf->produced.load( std::memory_order_acquire );
+   ringbuf_off_t consumed       = sbuf->consumed.load( std::memory_order_relaxed );
+   if( produced == consumed )
+   {
+      return 0;
+   }
+
+   size_t readOffset = consumed % sbuf->space;
+   if( produced - consumed > sbuf->space - readOffset )
+   {
+      /*
+       * The producer has wrapped around. Consume up to the 'end' offset,
+       * or skip the unused space if we have already reached it.
+       */
+      if( readOffset < sbuf->end )
+      {
+         *offset = readOffset;
+         return sbuf->end - readOffset;
+      }
+
+      consumed += sbuf->space - readOffset;
+      sbuf->consumed.store( consumed, std::memory_order_release );
+      readOffset = 0;
+   }
+
+   *offset = readOffset;
+   return produced - consumed;
+}
+
+/*
+ * spscbuf_release: indicate that the consumed range can now be released.
+ */
+void spscbuf_release( spscbuf_t* sbuf, size_t nbytes )
+{
+   const ringbuf_off_t consumed = sbuf->consumed.load( std::memory_order_relaxed );
+   sbuf->consumed.store( consumed + nbytes, std::memory_order_release );
+}
+
 #endif  // end HOP_IMPLEMENTATION
 
 #endif  // !defined(HOP_ENABLED)
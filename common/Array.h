@@ -68,6 +68,12 @@ struct Array
    T* data() { return &_data.data[0]; }
    const T* data() const { return &_data.data[0]; }
 
+   void swap( Array& rhs )
+   {
+      std::swap( _data.memblock, rhs._data.memblock );
+      std::swap( _count, rhs._count );
+   }
+
   private:
    union Data
    {
@@ -101,18 +101,27 @@ void release( void** block, uint32_t count )
 {
    assert( count > 0 );
 
-   // The new release blocks will become the new head
+   // Chain all the freed blocks together to create the new head. Blocks that were not
+   // acquired from the allocator, such as the ones mapped from a file, are skipped.
+   const uint8_t* base = (const uint8_t*)g_allocator._baseAlloc;
    BlockListHead newHead;
-   newHead.node = (MemoryBlock*)( (uint8_t*)block[0] - sizeof( MemoryBlock ) );
-
-   // Chain all the freed blocks together to create the new head
-   MemoryBlock* curBlock = newHead.node;
-   for( uint32_t i = 1; i < count; ++i )
+   newHead.node          = nullptr;
+   MemoryBlock* curBlock = nullptr;
+   for( uint32_t i = 0; i < count; ++i )
    {
-      curBlock->next = (MemoryBlock*)( (uint8_t*)block[i] - sizeof( MemoryBlock ) );
-      curBlock       = curBlock->next;
+      if( (uint8_t*)block[i] < base || (uint8_t*)block[i] >= base + g_allocator._vmAllocSize )
+         continue;
+
+      MemoryBlock* memBlock = (MemoryBlock*)( (uint8_t*)block[i] - sizeof( MemoryBlock ) );
+      if( curBlock )
+         curBlock->next = memBlock;
+      else
+         newHead.node = memBlock;
+      curBlock = memBlock;
    }
 
+   if( !curBlock ) return;
+
    BlockListHead prevHead = g_allocator._freeBlocks.load();
    do
    {
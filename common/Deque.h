@@ -11,8 +11,10 @@
 #include <cstdint>
 #include <cstring> // memcpy
 #include <cstddef>
+#include <initializer_list>
 #include <type_traits>
 #include <iostream>
+#include <vector>
 
 namespace hop
 {
@@ -36,27 +38,29 @@ class Deque
       using value_type = T;
       using reference  = T&;
       using difference_type = typename std::iterator<std::random_access_iterator_tag, T>::difference_type;
-      using BlockArrayPtr = typename std::conditional< Const, const BlockPtrContainer, BlockPtrContainer >::type;
+      using DequePtr = typename std::conditional< Const, const Deque, Deque >::type;
 
-      BlockArrayPtr* _blocks;
+      DequePtr* _deque;
       uint32_t _blockId;
       uint32_t _elementId;
 
-      iterator( BlockArrayPtr* lb ) : _blocks( lb ), _blockId( 0 ), _elementId( 0 ) {}
-      iterator( BlockArrayPtr* lb, uint32_t blockId, uint32_t elId ) : _blocks( lb ), _blockId( blockId ), _elementId( elId ) {}
+      iterator( DequePtr* deq ) : _deque( deq ), _blockId( 0 ), _elementId( 0 ) {}
+      iterator( DequePtr* deq, uint32_t blockId, uint32_t elId ) : _deque( deq ), _blockId( blockId ), _elementId( elId ) {}
       inline bool operator==(const iterator& rhs) const { return _blockId == rhs._blockId && _elementId == rhs._elementId; }
       inline bool operator!=(const iterator& rhs) const { return _blockId != rhs._blockId || _elementId != rhs._elementId; }
       inline reference operator[]( size_t idx ) { return *(this->operator+( idx ) ); }
       inline reference operator*() const
       {
-         assert( _blockId < _blocks->size() && _elementId < COUNT_PER_BLOCK );
-         return (*_blocks)[_blockId]->data[_elementId];
+         assert( _blockId < _deque->_blocks.size() && _elementId < COUNT_PER_BLOCK );
+         return _deque->_blocks[_blockId]->data[_elementId];
       }
       inline T* operator->() const
       {
-         assert( _blockId < _blocks->size() && _elementId < COUNT_PER_BLOCK );
-         return &(*_blocks)[_blockId]->data[_elementId];
+         assert( _blockId < _deque->_blocks.size() && _elementId < COUNT_PER_BLOCK );
+         return &_deque->_blocks[_blockId]->data[_elementId];
       }
+      // Position of the element in the deque
+      inline uint64_t index() const { return _deque->indexOf( _blockId, _elementId ); }
 
       inline bool operator>(const iterator& rhs) const { return std::make_pair(_blockId, _elementId) > std::make_pair(rhs._blockId, rhs._elementId);  }
       inline bool operator<(const iterator& rhs) const { return std::make_pair(_blockId, _elementId) < std::make_pair(rhs._blockId, rhs._elementId);  }
@@ -66,7 +70,11 @@ class Deque
       // Non const operators
       inline iterator& operator++()
       {
-         if( ++_elementId >= COUNT_PER_BLOCK )
+         // Only the blocks followed by spliced ones can be partial before the last one
+         const auto& blocks = _deque->_blocks;
+         if( ++_elementId >= COUNT_PER_BLOCK ||
+             ( !_deque->_blockStarts.empty() && _elementId >= blocks[_blockId]->elementCount &&
+               _blockId + 1 < blocks.size() ) )
          {
             _elementId = 0;
             ++_blockId;
@@ -84,7 +92,8 @@ class Deque
          {
             assert( _blockId > 0 );
             --_blockId;
-            _elementId = COUNT_PER_BLOCK - 1;
+            _elementId = _deque->_blockStarts.empty() ? COUNT_PER_BLOCK - 1
+                                                      : _deque->_blocks[_blockId]->elementCount - 1;
          }
          return *this;
       }
@@ -92,28 +101,14 @@ class Deque
 
       inline iterator& operator+=( difference_type val )
       {
-         const difference_type newVal = val + _elementId;
-         _blockId   += newVal / COUNT_PER_BLOCK;
-         _elementId =  newVal & (COUNT_PER_BLOCK-1);
+         _deque->locate( index() + val, _blockId, _elementId );
          return *this;
       }
 
       inline iterator& operator-=( difference_type val )
       {
-         const uint32_t quot = val / COUNT_PER_BLOCK;
-         const uint32_t rem  = val & (COUNT_PER_BLOCK-1);
-         assert( _blockId >= quot );
-         _blockId -= quot;
-         if( rem > _elementId )
-         {
-            assert( _blockId > 0 );
-            --_blockId;
-            _elementId = COUNT_PER_BLOCK - rem;
-         }
-         else
-         {
-            _elementId -= rem;
-         }
+         assert( (difference_type)index() >= val );
+         _deque->locate( index() - val, _blockId, _elementId );
          return *this;
       }
 
@@ -133,10 +128,7 @@ class Deque
 
       inline difference_type operator-( const iterator& it2 ) const
       {
-         difference_type diff = (difference_type)_blockId - (difference_type)it2._blockId;
-         diff *= COUNT_PER_BLOCK;
-         diff += (difference_type)_elementId - (difference_type)it2._elementId;
-         return diff;
+         return (difference_type)index() - (difference_type)it2.index();
       }
    };
    // clang-format on
@@ -157,6 +149,7 @@ class Deque
 
    Deque& operator=( const Deque& rhs )
    {
+      _blockStarts.clear();
       const int32_t originalSize = (int32_t)_blocks.size();
       const int32_t newSize      = (int32_t)rhs._blocks.size();
       const int32_t deltaBlocks  = originalSize - newSize; 
@@ -179,6 +172,7 @@ class Deque
       _size = rhs._size;
       for( int32_t i = 0; i < newSize; ++i )
          *_blocks[i] = *rhs._blocks[i];
+      _blockStarts = rhs._blockStarts;
 
       return *this;
    }
@@ -189,12 +183,28 @@ class Deque
 
    const T& operator[]( int64_t idx ) const
    {
-      return (*_blocks[idx/COUNT_PER_BLOCK])[idx & (COUNT_PER_BLOCK-1)];
+      if( _blockStarts.empty() )
+         return (*_blocks[idx/COUNT_PER_BLOCK])[idx & (COUNT_PER_BLOCK-1)];
+      const uint32_t blockId = blockOf( idx );
+      return (*_blocks[blockId])[idx - _blockStarts[blockId]];
    }
 
    T& operator[]( int64_t idx )
    {
-      return (*_blocks[idx/COUNT_PER_BLOCK])[idx & (COUNT_PER_BLOCK-1)];
+      if( _blockStarts.empty() )
+         return (*_blocks[idx/COUNT_PER_BLOCK])[idx & (COUNT_PER_BLOCK-1)];
+      const uint32_t blockId = blockOf( idx );
+      return (*_blocks[blockId])[idx - _blockStarts[blockId]];
+   }
+
+   // Index one past the last element of the block holding idx. The elements in
+   // between are contiguous in memory.
+   uint64_t contiguousEnd( uint64_t idx ) const
+   {
+      if( _blockStarts.empty() )
+         return ( idx / COUNT_PER_BLOCK + 1 ) * COUNT_PER_BLOCK;
+      const uint32_t blockId = blockOf( idx );
+      return _blockStarts[blockId] + _blocks[blockId]->elementCount;
    }
 
    T& front()
@@ -257,16 +267,16 @@ class Deque
    template< bool Const = false >
    void append( const Deque<T>::iterator<Const>& begin, const Deque<T>::iterator<Const>& end )
    {
-      assert( begin._blocks == end._blocks );
+      assert( begin._deque == end._deque );
       if( begin == end ) return;
 
-      const BlockPtrContainer* inBlocks = begin._blocks;
+      const BlockPtrContainer* inBlocks = &begin._deque->_blocks;
       uint32_t blkId = begin._blockId;
       uint32_t elId  = begin._elementId;
       for( ; blkId < end._blockId; ++blkId )
       {
          const Block* curBlock = (*inBlocks)[blkId];
-         append( &curBlock->data[elId], COUNT_PER_BLOCK - elId );
+         append( &curBlock->data[elId], curBlock->elementCount - elId );
          elId = 0; // From now on, we copy whole blocks
       }
 
@@ -288,6 +298,59 @@ class Deque
       append( begin, elementCount );
    }
 
+   // Move the content of rhs at the end of this deque, leaving rhs empty. The full
+   // blocks of rhs are adopted as is and only its partial last block is copied, so
+   // small appends do not leave a mostly empty block behind. When our last block is
+   // partial, it stays in the middle of the deque and the start of each block is
+   // tracked from then on.
+   void append( Deque&& rhs )
+   {
+      if( rhs.empty() ) return;
+
+      const Block* rhsLast     = rhs._blocks[rhs._blocks.size() - 1];
+      const bool copyLast      = rhsLast->elementCount < COUNT_PER_BLOCK;
+      const uint32_t adoptCount = rhs._blocks.size() - ( copyLast ? 1 : 0 );
+      if( adoptCount == 0 )
+      {
+         append( rhs.cbegin(), rhs.cend() );
+         rhs.clear();
+         return;
+      }
+
+      // Release our trailing empty block, if any, so no empty block is left in the middle
+      if( _blocks.size() > 0 && _blocks[_blocks.size() - 1]->elementCount == 0 )
+         releaseBlocks( _blocks.size() - 1, _blocks.size() );
+
+      // The starts are needed as soon as a partial block is followed by others, either
+      // our last one or one of rhs. An empty table cannot tell, as we may have no block.
+      const bool leavesPartialBlock =
+          _blocks.size() > 0 && _blocks[_blocks.size() - 1]->elementCount < COUNT_PER_BLOCK;
+      const bool trackStarts = !_blockStarts.empty() || leavesPartialBlock || !rhs._blockStarts.empty();
+      if( trackStarts && _blockStarts.empty() )
+      {
+         for( uint32_t i = 0; i < _blocks.size(); ++i )
+            _blockStarts.push_back( (uint64_t)i * COUNT_PER_BLOCK );
+      }
+
+      for( uint32_t i = 0; i < adoptCount; ++i )
+      {
+         if( trackStarts ) _blockStarts.push_back( _size );
+         _blocks.push_back( rhs._blocks[i] );
+         _size += rhs._blocks[i]->elementCount;
+      }
+
+      // Our last block is now a full one, so the copied elements start a new block
+      if( copyLast )
+      {
+         append( rhsLast->data.data(), rhsLast->elementCount );
+         rhs.releaseBlocks( adoptCount, rhs._blocks.size() );
+      }
+
+      rhs._blocks.clear();
+      rhs._blockStarts.clear();
+      rhs._size = 0;
+   }
+
    template< bool Const = false >
    void erase( const Deque<T>::iterator<Const>& el )
    {
@@ -296,6 +359,15 @@ class Deque
 
    void erase( Deque<T>::iterator<false> from, Deque<T>::iterator<false> to )
    {
+      // The erasure moves the elements assuming every block but the last is full
+      if( !_blockStarts.empty() )
+      {
+         const uint64_t fromIdx = from.index(), toIdx = to.index();
+         compact();
+         from = begin() + fromIdx;
+         to   = begin() + toIdx;
+      }
+
       assert( from._blockId <= to._blockId );
       const uint64_t removedCount = std::distance( from, to );
       assert( _size >= removedCount );
@@ -312,6 +384,30 @@ class Deque
       _size -= removedCount;
    }
 
+   // Remove the last count elements
+   void pop_back( uint64_t count = 1 )
+   {
+      assert( _size >= count );
+      _size -= count;
+      while( count > 0 )
+      {
+         Block* lastBlock       = _blocks.back();
+         const uint32_t removed = (uint32_t)std::min<uint64_t>( count, lastBlock->elementCount );
+         lastBlock->elementCount -= removed;
+         count -= removed;
+         if( lastBlock->elementCount == 0 ) releaseBlocks( _blocks.size() - 1, _blocks.size() );
+      }
+   }
+
+   // Move the elements so every block but the last one is full again
+   void compact()
+   {
+      if( _blockStarts.empty() ) return;
+      Deque packed;
+      packed.append( cbegin(), cend() );
+      swap( packed );
+   }
+
    void clear()
    {
       if( _blocks.size() > 0 )
@@ -319,6 +415,7 @@ class Deque
          block_allocator::release( (void**)_blocks.data(), _blocks.size() );
          _blocks.clear();
       }
+      _blockStarts.clear();
       _size = 0;
    }
 
@@ -327,25 +424,76 @@ class Deque
       clear();
    }
 
-   auto begin() const { return iterator<true>( &_blocks ); }
-   auto begin() { return iterator<false>( &_blocks ); }
-   auto cbegin() const { return iterator<true>( &_blocks ); }
-   auto end() const
+   // Exchange the blocks of both deques without copying any element
+   void swap( Deque& rhs )
    {
-      const uint64_t sz = size();
-      return iterator<true>( &_blocks, sz / COUNT_PER_BLOCK, sz & (COUNT_PER_BLOCK-1) );
+      _blocks.swap( rhs._blocks );
+      _blockStarts.swap( rhs._blockStarts );
+      std::swap( _size, rhs._size );
    }
-   auto end()
+
+   // Size of the blocks written by writeBlocks
+   uint64_t blocksSizeInBytes() const
    {
-      const uint64_t sz = size();
-      return iterator<false>( &_blocks, sz / COUNT_PER_BLOCK, sz & (COUNT_PER_BLOCK-1) );
+      return ( ( _size + COUNT_PER_BLOCK - 1 ) / COUNT_PER_BLOCK ) * sizeof( Block );
    }
-   auto cend() const
+
+   // Write the used blocks as they are laid out in memory, so that they can be used
+   // in place by adoptBlocks. The unused end of the last block is skipped rather than
+   // written, so it can be left as a hole in the file.
+   void writeBlocks( std::ostream& out ) const
    {
-      const uint64_t sz = size();
-      return iterator<true>( &_blocks, sz / COUNT_PER_BLOCK, sz & (COUNT_PER_BLOCK-1) );
+      // The blocks are written as if they were all full but the last one
+      if( !_blockStarts.empty() )
+      {
+         Deque packed;
+         packed.append( cbegin(), cend() );
+         packed.writeBlocks( out );
+         return;
+      }
+
+      const uint64_t blockCount = ( _size + COUNT_PER_BLOCK - 1 ) / COUNT_PER_BLOCK;
+      for( uint64_t i = 0; i < blockCount; ++i )
+      {
+         const Block* block       = _blocks[i];
+         const uint64_t usedBytes = (const char*)block->data.data() + block->elementCount * sizeof( T ) - (const char*)block;
+         out.write( (const char*)block, usedBytes );
+         out.seekp( sizeof( Block ) - usedBytes, std::ios_base::cur );
+      }
+   }
+
+   // Use the consecutive blocks written by writeBlocks, such as ones from a mapped
+   // file, as the content of this empty deque. They are used in place, so they must
+   // remain valid and writable for the lifetime of the deque. They are not given to
+   // the block allocator when released.
+   void adoptBlocks( char* blocks, uint64_t size )
+   {
+      assert( empty() );
+      clear();
+
+      const uint64_t blockCount = ( size + COUNT_PER_BLOCK - 1 ) / COUNT_PER_BLOCK;
+      for( uint64_t i = 0; i < blockCount; ++i )
+         _blocks.push_back( (Block*)( blocks + i * sizeof( Block ) ) );
+      _size = size;
    }
 
+   auto begin() const { return iterator<true>( this ); }
+   auto begin() { return iterator<false>( this ); }
+   auto cbegin() const { return iterator<true>( this ); }
+   auto end() const
+   {
+      iterator<true> it( this );
+      locate( size(), it._blockId, it._elementId );
+      return it;
+   }
+   auto end()
+   {
+      iterator<false> it( this );
+      locate( size(), it._blockId, it._elementId );
+      return it;
+   }
+   auto cend() const { return end(); }
+
    friend std::ostream& operator<<( std::ostream& out, const Deque& bsv )
    {
       std::cout << "\n";
@@ -366,6 +514,8 @@ class Deque
   private:
     void acquireNewBlock()
     {
+        if( !_blockStarts.empty() )
+           _blockStarts.push_back( _blockStarts.back() + _blocks[_blocks.size() - 1]->elementCount );
         Block* newBlock = (Block*) block_allocator::acquire();
         newBlock->elementCount = 0;
         _blocks.push_back( newBlock );
@@ -376,6 +526,51 @@ class Deque
        assert( to > from );
        block_allocator::release( (void**)&_blocks[from], to - from );
        _blocks.erase( from, to );
+       if( !_blockStarts.empty() )
+       {
+          _blockStarts.erase( _blockStarts.begin() + from, _blockStarts.begin() + to );
+          // Stop tracking the starts once the partial blocks are gone. As no block holds more
+          // than COUNT_PER_BLOCK elements, the blocks before the last one are then all full.
+          if( _blocks.size() <= 1 || _blockStarts.back() == ( _blocks.size() - 1 ) * (uint64_t)COUNT_PER_BLOCK )
+             _blockStarts.clear();
+       }
+    }
+
+    // Block holding the element at idx, when the block starts are tracked
+    uint32_t blockOf( uint64_t idx ) const
+    {
+       assert( !_blockStarts.empty() && idx < _size );
+       return (uint32_t)( std::upper_bound( _blockStarts.begin(), _blockStarts.end(), idx ) - _blockStarts.begin() - 1 );
+    }
+
+    // Block and position in the block of the element at idx. The size of the deque
+    // gives the end position.
+    void locate( uint64_t idx, uint32_t& blockId, uint32_t& elementId ) const
+    {
+       if( _blockStarts.empty() )
+       {
+          blockId   = idx / COUNT_PER_BLOCK;
+          elementId = idx & ( COUNT_PER_BLOCK - 1 );
+       }
+       else if( idx < _size )
+       {
+          blockId   = blockOf( idx );
+          elementId = idx - _blockStarts[blockId];
+       }
+       else
+       {
+          assert( idx == _size );
+          const Block* lastBlock = _blocks[_blocks.size() - 1];
+          const bool lastIsFull  = lastBlock->elementCount == COUNT_PER_BLOCK;
+          blockId   = _blocks.size() - ( lastIsFull ? 0 : 1 );
+          elementId = lastIsFull ? 0 : lastBlock->elementCount;
+       }
+    }
+
+    uint64_t indexOf( uint32_t blockId, uint32_t elementId ) const
+    {
+       if( _blockStarts.empty() ) return (uint64_t)blockId * COUNT_PER_BLOCK + elementId;
+       return ( blockId < _blockStarts.size() ? _blockStarts[blockId] : _size ) + elementId;
     }
 
     /* Rotate the block containing the element to leave emtpy space at the end
@@ -548,8 +743,34 @@ class Deque
 
    uint64_t _size;
    BlockPtrContainer _blocks;
+   // Index of the first element of each block. Only tracked once a splice left a
+   // partial block before the last one, otherwise the blocks are found by division.
+   std::vector<uint64_t> _blockStarts;
 };
 
+// Call fct( firstIdx, count, const Ts* data... ) on consecutive spans of the [from, to)
+// range whose elements are contiguous in memory in every deque, so that the hot loops
+// can work on raw arrays. As the blocks of deques of different types do not hold the
+// same number of elements, and spliced deques can have partial blocks, each span ends
+// at the first block end of any of the deques.
+template <typename F, typename... Ts>
+void forEachSpan( uint64_t from, uint64_t to, const F& fct, const Deque<Ts>&... deques )
+{
+#ifndef NDEBUG
+   for( uint64_t size : {deques.size()...} )
+      assert( size >= to );
+#endif
+
+   while( from < to )
+   {
+      uint64_t end = to;
+      for( uint64_t blockEnd : {deques.contiguousEnd( from )...} )
+         end = std::min( end, blockEnd );
+      fct( from, end - from, &deques[from]... );
+      from = end;
+   }
+}
+
 }  // namespace hop
 
 #endif // HOP_DEQUE_H_
@@ -1,17 +1,40 @@
 #include "common/Profiler.h"
 #include "common/Utils.h"
+#include "common/platform/Platform.h"
 
 #include "miniz.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdio> // remove, rename
 #include <fstream>
+#include <limits>
 #include <numeric> // accumulate
+#include <thread>
+
+// Amount of uncompressed data accumulated before a chunk is written to the stream file
+static constexpr size_t STREAM_CHUNK_SIZE = 4 * 1024 * 1024;
+// Maximum time between two chunks, which bounds the data lost if the recorder is killed
+static constexpr std::chrono::milliseconds STREAM_FLUSH_INTERVAL{1000};
+// Number of entries in each chunk of a chunked file
+static constexpr size_t ENTRIES_PER_CHUNK = 64 * 1024;
+// Maximum number of chunks loaded at once, so that opening a big file does not stall the viewer
+static constexpr size_t MAX_CHUNKS_LOADED_PER_CALL = 8;
+
+static bool uncompressChunk( const std::vector<char>& src, size_t uncompressedSize, std::vector<char>& dst )
+{
+   dst.resize( uncompressedSize );
+   mz_ulong dstSize = uncompressedSize;
+   const int uncompressStatus = uncompress(
+       (unsigned char*)dst.data(), &dstSize, (const unsigned char*)src.data(), src.size() );
+   return uncompressStatus == Z_OK && dstSize == uncompressedSize;
+}
 
 namespace hop
 {
 Profiler::Profiler( SourceType type, int processId, const char* str )
     : _name( str ),
+      _strDb( true ),
       _recording( false ),
       _srcType( type ),
       _loadedFileCpuFreqGHz( 0 ),
@@ -84,11 +107,19 @@ ProfilerStats Profiler::stats() const
    ProfilerStats stats = {};
    stats.strDbSize = _strDb.sizeInBytes();
    stats.clientSharedMemSize = _server.sharedMemorySize();
+   stats.traceCount = _streamedTraceCount;
    for ( size_t i = 0; i < _tracks.size(); ++i )
    {
       stats.traceCount += _tracks[i]._traces.entries.ends.size();
    }
 
+   _server.droppedData( stats.droppedPerThread );
+   for( const auto& dropped : stats.droppedPerThread )
+   {
+      stats.droppedMsgCount += dropped.msgCount;
+      stats.droppedTraceCount += dropped.traceCount;
+   }
+
    return stats;
 }
 
@@ -98,47 +129,73 @@ bool Profiler::fetchClientData()
 
    bool got_data = false;
 
-   _server.getPendingData( _serverPendingData );
+   // Process all the batches published by the server since the last fetch
+   while ( _server.getPendingData( _serverPendingData ) )
+   {
+      if( _streamFile.is_open() )
+      {
+         got_data |= streamPendingData( _serverPendingData );
+         if( _streamBuffer.size() >= STREAM_CHUNK_SIZE ) flushStreamChunk();
+      }
+      else
+      {
+         got_data |= addPendingData( _serverPendingData, _recording );
+      }
+   }
 
-   if ( _recording )
+   if( _streamFile.is_open() &&
+       std::chrono::steady_clock::now() - _lastStreamFlush >= STREAM_FLUSH_INTERVAL )
+   {
+      flushStreamChunk();
+   }
+
+   return got_data;
+}
+
+bool Profiler::addPendingData( Server::PendingData& pendingData, bool recording )
+{
+   HOP_PROF_FUNC();
+
+   bool got_data = false;
+   if ( recording )
    {
       HOP_PROF_SPLIT( "Fetching Str Data" );
 
-      addStringData( _serverPendingData.stringData );
+      addStringData( pendingData.stringData );
 
       HOP_PROF_SPLIT( "Fetching Traces" );
-      for( const auto& threadTraces : _serverPendingData.tracesPerThread )
+      for( auto& threadTraces : pendingData.tracesPerThread )
       {
-         got_data |= addTraces( threadTraces.second, threadTraces.first );
+         got_data |= addTraces( std::move( threadTraces.second ), threadTraces.first );
       }
       HOP_PROF_SPLIT( "Fetching Lock Waits" );
-      for( const auto& lockwaits : _serverPendingData.lockWaitsPerThread )
+      for( auto& lockwaits : pendingData.lockWaitsPerThread )
       {
-         got_data |= addLockWaits( lockwaits.second, lockwaits.first );
+         got_data |= addLockWaits( std::move( lockwaits.second ), lockwaits.first );
       }
       HOP_PROF_SPLIT( "Fetching Unlock Events" );
-      for( const auto& unlockEvents : _serverPendingData.unlockEventsPerThread )
+      for( const auto& unlockEvents : pendingData.unlockEventsPerThread )
       {
          got_data |= addUnlockEvents( unlockEvents.second, unlockEvents.first );
       }
       HOP_PROF_SPLIT( "Fetching CoreEvents" );
-      for( const auto& coreEvents : _serverPendingData.coreEventsPerThread )
+      for( auto& coreEvents : pendingData.coreEventsPerThread )
       {
-         got_data |= addCoreEvents( coreEvents.second, coreEvents.first );
+         got_data |= addCoreEvents( std::move( coreEvents.second ), coreEvents.first );
       }
    }
 
    // We need to get the thread name even when not recording as they are only sent once
-   for ( size_t i = 0; i < _serverPendingData.threadNames.size(); ++i )
+   for ( size_t i = 0; i < pendingData.threadNames.size(); ++i )
    {
-      addThreadName(
-          _serverPendingData.threadNames[i].second, _serverPendingData.threadNames[i].first );
+      addThreadName( pendingData.threadNames[i].second, pendingData.threadNames[i].first );
       got_data |= true;
    }
+
    return got_data;
 }
 
-bool Profiler::addTraces( const TraceData& traces, uint32_t threadIndex )
+bool Profiler::addTraces( TraceData&& traces, uint32_t threadIndex )
 {
    // Ignore empty traces
    if ( traces.entries.ends.empty() ) return false;
@@ -165,7 +222,7 @@ bool Profiler::addTraces( const TraceData& traces, uint32_t threadIndex )
          _earliestTimeStamp = newEarliestTime;
    }
 
-   _tracks[threadIndex].addTraces( traces );
+   _tracks[threadIndex].addTraces( std::move( traces ) );
    return true;
 }
 
@@ -181,7 +238,7 @@ bool Profiler::addStringData( const std::vector<char>& strData )
    return true;
 }
 
-bool Profiler::addLockWaits( const LockWaitData& lockWaits, uint32_t threadIndex )
+bool Profiler::addLockWaits( LockWaitData&& lockWaits, uint32_t threadIndex )
 {
    HOP_PROF_FUNC();
    // Check if new thread
@@ -193,7 +250,7 @@ bool Profiler::addLockWaits( const LockWaitData& lockWaits, uint32_t threadIndex
    if ( lockWaits.entries.ends.empty() )
       return false;
 
-   _tracks[threadIndex].addLockWaits( lockWaits );
+   _tracks[threadIndex].addLockWaits( std::move( lockWaits ) );
    return true;
 }
 
@@ -213,7 +270,7 @@ bool Profiler::addUnlockEvents( const std::vector<UnlockEvent>& unlockEvents, ui
    return true;
 }
 
-bool Profiler::addCoreEvents( const CoreEventData& coreEvents, uint32_t threadIndex )
+bool Profiler::addCoreEvents( CoreEventData&& coreEvents, uint32_t threadIndex )
 {
    HOP_PROF_FUNC();
    // Check if new thread
@@ -225,7 +282,7 @@ bool Profiler::addCoreEvents( const CoreEventData& coreEvents, uint32_t threadIn
    if ( coreEvents.cores.empty() )
       return false;
 
-   _tracks[threadIndex].addCoreEvents( coreEvents );
+   _tracks[threadIndex].addCoreEvents( std::move( coreEvents ) );
    return true;
 }
 
@@ -253,56 +310,257 @@ struct SaveFileHeader
    uint32_t threadCount;
 };
 
-bool hop::Profiler::saveToFile( const char* savePath )
+// A streamed file starts with a SaveFileHeader, of which only the version and cpu
+// frequency are used, followed by independently compressed chunks. Each chunk holds
+// serialized server batches that are replayed in order when the file is opened. A
+// truncated chunk at the end of the file is ignored.
+const uint32_t STREAM_MAGIC_NUMBER = 1397772104;  // "HOPS"
+const uint32_t CHUNK_MAGIC_NUMBER  = 1263421507;  // "CHNK"
+struct StreamChunkHeader
+{
+   uint32_t magicNumber;
+   float    cpuFreqGHz;
+   uint64_t uncompressedSize;
+   uint64_t compressedSize;
+};
+
+// A chunked file starts with a SaveFileHeader followed by independently compressed
+// chunks. The first one holds the string database and the track names, the others
+// hold up to ENTRIES_PER_CHUNK entries of a single track. The index of the chunks
+// and their time ranges is written at the end of the file, before a ChunkedFileFooter.
+const uint32_t CHUNKED_MAGIC_NUMBER = 1129336648;  // "HOPC"
+enum ChunkType : uint32_t
+{
+   CHUNK_TYPE_METADATA,
+   CHUNK_TYPE_TRACES,
+   CHUNK_TYPE_LOCK_WAITS,
+   CHUNK_TYPE_CORE_EVENTS,
+};
+struct ChunkedFileFooter
+{
+   uint64_t indexOffset;
+   uint32_t chunkCount;
+   uint32_t magicNumber;
+};
+
+// A mapped file is not compressed, so that it can be mapped in memory and its data
+// used in place. It starts with a SaveFileHeader followed by the same metadata as a
+// chunked file. Then come the deque blocks of every column of the tracks, each column
+// starting on a new page. A MappedTrackInfo per track is written at the end of the
+// file, before a ChunkedFileFooter.
+const uint32_t MAPPED_MAGIC_NUMBER = 1297108808;  // "HOPM"
+static constexpr uint64_t MAPPED_COLUMN_ALIGNMENT = 4096;
+struct MappedTrackInfo
+{
+   uint64_t traceCount;
+   uint64_t lockWaitCount;
+   uint64_t coreEventCount;
+   uint32_t traceMaxDepth;
+   uint32_t lockWaitMaxDepth;
+   uint32_t coreEventMaxDepth;
+   uint32_t columnCount;
+   uint64_t columnOffsets[16];
+};
+
+template <typename T>
+static void writeMappedColumn( std::ofstream& of, const Deque<T>& column, MappedTrackInfo* info )
+{
+   const uint64_t offset = of.tellp();
+   const uint64_t padding = ( MAPPED_COLUMN_ALIGNMENT - offset % MAPPED_COLUMN_ALIGNMENT ) % MAPPED_COLUMN_ALIGNMENT;
+   const char zeros[MAPPED_COLUMN_ALIGNMENT] = {};
+   of.write( zeros, padding );
+
+   info->columnOffsets[info->columnCount++] = offset + padding;
+   column.writeBlocks( of );
+}
+
+template <typename T>
+static bool mapColumn( char* file, uint64_t fileSize, uint64_t count, const MappedTrackInfo& info, uint32_t* columnIdx, Deque<T>& column )
+{
+   const uint64_t offset = info.columnOffsets[( *columnIdx )++];
+   column.adoptBlocks( file + offset, count );
+   return offset + column.blocksSizeInBytes() <= fileSize;
+}
+
+bool hop::Profiler::saveToFile( const char* savePath, bool mappable )
 {
    HOP_PROF_FUNC();
    setRecording( false );
-   // Compute the size of the serialized data
-   const mz_ulong dbSerializedSize = serializedSize( _strDb );
-   mz_ulong timelineTracksSerializedSize = 0;
-   for( size_t i = 0; i < _tracks.size(); ++i )
+
+   // A lazily opened file needs to be fully loaded before being written back
+   loadAllChunks();
+   const size_t batchSize = std::max( std::thread::hardware_concurrency(), 1u ) * 2;
+
+   // The data of a mapped file is used in place, so the file must not be overwritten
+   // while we read from it. Write to a temporary file that then replaces it.
+   std::string path = savePath;
+   if( _mappedFile ) path += ".tmp";
+
+   bool success = mappable ? saveMappedFile( path.c_str() ) : saveChunkedFile( path.c_str(), batchSize );
+   if( success && _mappedFile )
    {
-      timelineTracksSerializedSize += serializedSize( _tracks[i] );
+      std::remove( savePath );
+      success = std::rename( path.c_str(), savePath ) == 0;
    }
 
-   const mz_ulong totalSerializedSize = timelineTracksSerializedSize + dbSerializedSize;
-
-   std::vector<char> data( totalSerializedSize );
+   return success;
+}
 
-   size_t index = serialize( _strDb, &data[0] );
-   for( size_t i = 0; i < _tracks.size(); ++i )
+void Profiler::serializeMetadata( std::vector<char>& dst ) const
+{
+   const uint32_t trackCount = _tracks.size();
+   dst.resize( serializedSize( _strDb ) + sizeof( trackCount ) + trackCount * sizeof( StrPtr_t ) );
+   size_t i = serialize( _strDb, dst.data() );
+   memcpy( &dst[i], &trackCount, sizeof( trackCount ) );
+   i += sizeof( trackCount );
+   for( uint32_t t = 0; t < trackCount; ++t )
    {
-      index += serialize( _tracks[i], &data[index] );
+      const StrPtr_t name = _tracks[t].name();
+      memcpy( &dst[i], &name, sizeof( name ) );
+      i += sizeof( name );
    }
+}
 
-   HOP_PROF_SPLIT( "Compressing" );
-   mz_ulong compressedSize = compressBound( totalSerializedSize );
-   std::vector<char> compressedData( compressedSize );
-   int compressionStatus = compress(
-       (unsigned char*)compressedData.data(),
-       &compressedSize,
-       (const unsigned char*)&data[0],
-       totalSerializedSize );
-   if( compressionStatus != Z_OK )
+void Profiler::addMetadata( const char* src )
+{
+   size_t i = deserialize( src, _strDb );
+   uint32_t trackCount;
+   memcpy( &trackCount, &src[i], sizeof( trackCount ) );
+   i += sizeof( trackCount );
+   _tracks.resize( trackCount );
+   for( uint32_t t = 0; t < trackCount; ++t )
    {
-      fprintf( stderr, "Compression failed. File not saved!" );
-      return false;
+      StrPtr_t name;
+      memcpy( &name, &src[i], sizeof( name ) );
+      i += sizeof( name );
+      if( name ) addThreadName( name, t );
    }
+}
 
-   HOP_PROF_SPLIT( "Writing to disk" );
+bool Profiler::saveChunkedFile( const char* savePath, size_t batchSize )
+{
+   HOP_PROF_FUNC();
    std::ofstream of( savePath, std::ofstream::binary );
-   if( of.is_open() )
+   if( !of.is_open() ) return false;
+
+   // The header is rewritten once the total size is known
+   SaveFileHeader header = {CHUNKED_MAGIC_NUMBER,
+                            HOP_VERSION,
+                            cpuFreqGHz(),
+                            0,
+                            (uint32_t)serializedSize( _strDb ),
+                            (uint32_t)_tracks.size()};
+   of.write( (const char*)&header, sizeof( header ) );
+
+   // List the chunks to write. The metadata chunk is identified by its type alone.
+   struct ChunkJob
+   {
+      uint32_t type;
+      uint32_t trackIndex;
+      size_t from;
+      size_t to;
+   };
+   std::vector<ChunkJob> jobs( 1, ChunkJob{CHUNK_TYPE_METADATA, 0, 0, 0} );
+   for( uint32_t t = 0; t < _tracks.size(); ++t )
+   {
+      const size_t counts[] = {_tracks[t]._traces.entries.ends.size(),
+                               _tracks[t]._lockWaits.entries.ends.size(),
+                               _tracks[t]._coreEvents.cores.size()};
+      const uint32_t types[] = {CHUNK_TYPE_TRACES, CHUNK_TYPE_LOCK_WAITS, CHUNK_TYPE_CORE_EVENTS};
+      for( size_t j = 0; j < 3; ++j )
+      {
+         for( size_t from = 0; from < counts[j]; from += ENTRIES_PER_CHUNK )
+         {
+            jobs.push_back( ChunkJob{types[j], t, from, std::min( from + ENTRIES_PER_CHUNK, counts[j] )} );
+         }
+      }
+   }
+
+   // Find the time range covered by the [from, to) entries
+   const auto entriesRange = []( const Entries& entries, size_t from, size_t to, TimeStamp* start, TimeStamp* end ) {
+      *start = *std::min_element( entries.starts.begin() + from, entries.starts.begin() + to );
+      *end   = *std::max_element( entries.ends.begin() + from, entries.ends.begin() + to );
+   };
+
+   // Serialize and compress a chunk. Only reads the profiler data, so it can be called
+   // from multiple threads.
+   const auto compressChunk = [&]( const ChunkJob& job, std::vector<char>& data, std::vector<char>& compressedData, ChunkInfo* info ) {
+      *info = ChunkInfo{0, 0, 0, 0, 0, job.trackIndex, job.type};
+      const TimelineTrack* track = job.type != CHUNK_TYPE_METADATA ? &_tracks[job.trackIndex] : nullptr;
+      switch( job.type )
+      {
+         case CHUNK_TYPE_METADATA:
+            serializeMetadata( data );
+            break;
+         case CHUNK_TYPE_TRACES:
+            data.resize( serializedSize( track->_traces, job.from, job.to ) );
+            serialize( track->_traces, job.from, job.to, data.data() );
+            entriesRange( track->_traces.entries, job.from, job.to, &info->start, &info->end );
+            break;
+         case CHUNK_TYPE_LOCK_WAITS:
+            data.resize( serializedSize( track->_lockWaits, job.from, job.to ) );
+            serialize( track->_lockWaits, job.from, job.to, data.data() );
+            entriesRange( track->_lockWaits.entries, job.from, job.to, &info->start, &info->end );
+            break;
+         case CHUNK_TYPE_CORE_EVENTS:
+            data.resize( serializedSize( track->_coreEvents, job.from, job.to ) );
+            serialize( track->_coreEvents, job.from, job.to, data.data() );
+            entriesRange( track->_coreEvents.entries, job.from, job.to, &info->start, &info->end );
+            break;
+      }
+
+      mz_ulong compressedSize = compressBound( data.size() );
+      compressedData.resize( compressedSize );
+      const int compressionStatus = compress(
+          (unsigned char*)compressedData.data(),
+          &compressedSize,
+          (const unsigned char*)data.data(),
+          data.size() );
+      compressedData.resize( compressedSize );
+      info->uncompressedSize = data.size();
+      return compressionStatus == Z_OK;
+   };
+
+   // The chunks are compressed in parallel by batches, so that only a few of them are
+   // held in memory, and are then written in order
+   HOP_PROF_SPLIT( "Compressing and writing chunks" );
+   std::vector<std::vector<char> > data( batchSize ), compressedData( batchSize );
+   std::vector<ChunkInfo> chunks( jobs.size() );
+   std::vector<uint8_t> compressed( batchSize );
+   bool success = true;
+   for( size_t batchStart = 0; batchStart < jobs.size() && success; batchStart += batchSize )
    {
-      SaveFileHeader header = {MAGIC_NUMBER,
-                               HOP_VERSION,
-                               cpuFreqGHz(),
-                               totalSerializedSize,
-                               (uint32_t)dbSerializedSize,
-                               (uint32_t)_tracks.size()};
-      of.write( (const char*)&header, sizeof( header ) );
-      of.write( &compressedData[0], compressedSize );
+      const size_t count = std::min( batchSize, jobs.size() - batchStart );
+      parallelFor( count, [&]( size_t i ) {
+         compressed[i] = compressChunk( jobs[batchStart + i], data[i], compressedData[i], &chunks[batchStart + i] );
+      } );
+
+      for( size_t i = 0; i < count && success; ++i )
+      {
+         ChunkInfo& info     = chunks[batchStart + i];
+         info.offset         = of.tellp();
+         info.compressedSize = compressedData[i].size();
+         header.uncompressedSize += info.uncompressedSize;
+         of.write( compressedData[i].data(), compressedData[i].size() );
+         success = compressed[i] && of.good();
+      }
+   }
+
+   if( !success )
+   {
+      fprintf( stderr, "Failed to write chunk. File not saved!\n" );
+      return false;
    }
 
+   HOP_PROF_SPLIT( "Writing index" );
+   const ChunkedFileFooter footer = {
+       (uint64_t)of.tellp(), (uint32_t)chunks.size(), CHUNKED_MAGIC_NUMBER};
+   of.write( (const char*)chunks.data(), chunks.size() * sizeof( ChunkInfo ) );
+   of.write( (const char*)&footer, sizeof( footer ) );
+
+   of.seekp( 0 );
+   of.write( (const char*)&header, sizeof( header ) );
+
    return of.good();
 }
 
@@ -314,35 +572,53 @@ bool hop::Profiler::openFile( const char* path )
 
    clear();  // Remove any existing data
 
-   std::vector<char> data(
-       ( std::istreambuf_iterator<char>( input ) ), ( std::istreambuf_iterator<char>() ) );
-
-   SaveFileHeader* header = (SaveFileHeader*)&data[0];
-   if( header->magicNumber != MAGIC_NUMBER )
+   SaveFileHeader header;
+   if( !input.read( (char*)&header, sizeof( header ) ) ||
+       ( header.magicNumber != MAGIC_NUMBER && header.magicNumber != STREAM_MAGIC_NUMBER &&
+         header.magicNumber != CHUNKED_MAGIC_NUMBER && header.magicNumber != MAPPED_MAGIC_NUMBER ) )
    {
       fprintf(stderr, "Magic number does not match\n" );
       return false;
    }
 
-   if( header->version != HOP_VERSION )
+   if( header.version != HOP_VERSION )
    {
       fprintf(
           stderr,
           "Hop file version %f does not match viewer version %f\n",
-          header->version,
+          header.version,
           HOP_VERSION );
       return false;
    }
 
+   _loadedFileCpuFreqGHz = header.cpuFreqGHz;
+
+   if( header.magicNumber == STREAM_MAGIC_NUMBER )
+   {
+      return openStreamedFile( input );
+   }
+   else if( header.magicNumber == CHUNKED_MAGIC_NUMBER )
+   {
+      return openChunkedFile( input );
+   }
+   else if( header.magicNumber == MAPPED_MAGIC_NUMBER )
+   {
+      input.close();
+      return openMappedFile( path );
+   }
+
+   std::vector<char> data(
+       ( std::istreambuf_iterator<char>( input ) ), ( std::istreambuf_iterator<char>() ) );
+
    HOP_PROF_SPLIT( "Uncompressing" );
-   std::vector<char> uncompressedData( header->uncompressedSize );
+   std::vector<char> uncompressedData( header.uncompressedSize );
    mz_ulong uncompressedSize = uncompressedData.size();
 
    int uncompressStatus = uncompress(
        (unsigned char*)uncompressedData.data(),
        &uncompressedSize,
-       (unsigned char*)&data[sizeof( SaveFileHeader )],
-       data.size() - sizeof( SaveFileHeader ) );
+       (unsigned char*)data.data(),
+       data.size() );
 
    if( uncompressStatus != Z_OK )
    {
@@ -351,20 +627,18 @@ bool hop::Profiler::openFile( const char* path )
 
    HOP_PROF_SPLIT( "Updating data" );
 
-   _loadedFileCpuFreqGHz = header->cpuFreqGHz;
-
    size_t i            = 0;
    const size_t dbSize = deserialize( &uncompressedData[i], _strDb );
-   assert( dbSize == header->strDbSize );
+   assert( dbSize == header.strDbSize );
    i += dbSize;
 
-   std::vector<TimelineTrack> timelineTracks( header->threadCount );
-   for( uint32_t j = 0; j < header->threadCount; ++j )
+   std::vector<TimelineTrack> timelineTracks( header.threadCount );
+   for( uint32_t j = 0; j < header.threadCount; ++j )
    {
       size_t timelineTrackSize = deserialize( &uncompressedData[i], timelineTracks[j] );
-      addTraces( timelineTracks[j]._traces, j );
-      addLockWaits( timelineTracks[j]._lockWaits, j );
-      addCoreEvents( timelineTracks[j]._coreEvents, j );
+      addTraces( std::move( timelineTracks[j]._traces ), j );
+      addLockWaits( std::move( timelineTracks[j]._lockWaits ), j );
+      addCoreEvents( std::move( timelineTracks[j]._coreEvents ), j );
       if (timelineTracks[j].name ())
          addThreadName( timelineTracks[j].name (), j );
       i += timelineTrackSize;
@@ -374,14 +648,557 @@ bool hop::Profiler::openFile( const char* path )
    return true;
 }
 
+bool Profiler::openStreamedFile( std::ifstream& input )
+{
+   HOP_PROF_FUNC();
+   std::vector<char> compressedData, uncompressedData;
+   Server::PendingData pendingData;
+
+   StreamChunkHeader chunk;
+   while( input.read( (char*)&chunk, sizeof( chunk ) ) )
+   {
+      if( chunk.magicNumber != CHUNK_MAGIC_NUMBER )
+      {
+         fprintf( stderr, "Invalid chunk found in streamed file. Ignoring the rest of the file\n" );
+         break;
+      }
+
+      compressedData.resize( chunk.compressedSize );
+      if( !input.read( compressedData.data(), compressedData.size() ) )
+      {
+         fprintf( stderr, "Last chunk of streamed file is incomplete and was ignored\n" );
+         break;
+      }
+
+      uncompressedData.resize( chunk.uncompressedSize );
+      mz_ulong uncompressedSize = uncompressedData.size();
+      const int uncompressStatus = uncompress(
+          (unsigned char*)uncompressedData.data(),
+          &uncompressedSize,
+          (const unsigned char*)compressedData.data(),
+          compressedData.size() );
+      if( uncompressStatus != Z_OK || uncompressedSize != chunk.uncompressedSize )
+      {
+         fprintf( stderr, "Could not uncompress chunk. Ignoring the rest of the file\n" );
+         break;
+      }
+
+      // The cpu frequency might not have been known when the recording started
+      if( chunk.cpuFreqGHz > 0 ) _loadedFileCpuFreqGHz = chunk.cpuFreqGHz;
+
+      // Replay the batches as they were received by the recorder
+      size_t i = 0;
+      while( i < uncompressedData.size() )
+      {
+         pendingData.clear();
+         i += deserialize( &uncompressedData[i], pendingData );
+         addPendingData( pendingData, true );
+      }
+   }
+   _srcType = SRC_TYPE_FILE;
+
+   return true;
+}
+
+bool Profiler::openChunkedFile( std::ifstream& input )
+{
+   HOP_PROF_FUNC();
+   ChunkedFileFooter footer;
+   input.seekg( -(std::streamoff)sizeof( footer ), std::ifstream::end );
+   if( !input.read( (char*)&footer, sizeof( footer ) ) || footer.magicNumber != CHUNKED_MAGIC_NUMBER )
+   {
+      fprintf( stderr, "Chunked file has no valid index\n" );
+      return false;
+   }
+
+   _fileChunks.resize( footer.chunkCount );
+   input.seekg( footer.indexOffset );
+   if( !input.read( (char*)_fileChunks.data(), _fileChunks.size() * sizeof( ChunkInfo ) ) ||
+       _fileChunks.empty() || _fileChunks[0].type != CHUNK_TYPE_METADATA )
+   {
+      fprintf( stderr, "Could not read chunked file index\n" );
+      _fileChunks.clear();
+      return false;
+   }
+
+   _chunkedFile.swap( input );
+   std::vector<char> compressedMetadata, metadata;
+   if( !readChunk( 0, compressedMetadata ) ||
+       !uncompressChunk( compressedMetadata, _fileChunks[0].uncompressedSize, metadata ) ||
+       !addChunk( _fileChunks[0], metadata.data() ) )
+   {
+      fprintf( stderr, "Could not load chunked file metadata\n" );
+      _chunkedFile.close();
+      _fileChunks.clear();
+      return false;
+   }
+
+   // Split the remaining chunks in streams of the same track and type, and find the
+   // earliest time from which each chunk has to be loaded
+   _fileChunksMinStart.resize( _fileChunks.size() );
+   for( size_t i = 1; i < _fileChunks.size(); ++i )
+   {
+      const ChunkInfo& chunk = _fileChunks[i];
+      const ChunkInfo& prev  = _fileChunks[i - 1];
+      if( i == 1 || chunk.trackIndex != prev.trackIndex || chunk.type != prev.type )
+      {
+         _chunkStreams.push_back( ChunkStream{i, i} );
+      }
+      ++_chunkStreams.back().end;
+
+      if( _earliestTimeStamp == 0 || chunk.start < _earliestTimeStamp ) _earliestTimeStamp = chunk.start;
+      _latestTimeStamp = std::max( chunk.end, _latestTimeStamp );
+   }
+   for( const ChunkStream& stream : _chunkStreams )
+   {
+      TimeStamp minStart = std::numeric_limits<TimeStamp>::max();
+      for( size_t i = stream.end; i-- > stream.next; )
+      {
+         minStart                 = std::min( minStart, _fileChunks[i].start );
+         _fileChunksMinStart[i] = minStart;
+      }
+   }
+
+   _srcType = SRC_TYPE_FILE;
+
+   return true;
+}
+
+bool Profiler::loadChunksUntil( TimeStamp time )
+{
+   return loadChunks( time, MAX_CHUNKS_LOADED_PER_CALL );
+}
+
+void Profiler::loadAllChunks()
+{
+   const size_t batchSize = std::max( std::thread::hardware_concurrency(), 1u ) * 2;
+   while( loadChunks( std::numeric_limits<TimeStamp>::max(), batchSize ) ) {}
+}
+
+bool Profiler::fullyLoaded() const
+{
+   // The file is closed once all its chunks were loaded
+   return !_chunkedFile.is_open();
+}
+
+bool Profiler::loadChunks( TimeStamp time, size_t maxChunkCount )
+{
+   if( !_chunkedFile.is_open() ) return false;
+
+   HOP_PROF_FUNC();
+
+   // Pick the chunks to load by going over the streams in turn, so that all the tracks
+   // get loaded at the same pace
+   std::vector<size_t> chunksToLoad, chunkStreams;
+   bool picked = true;
+   while( picked && chunksToLoad.size() < maxChunkCount )
+   {
+      picked = false;
+      for( size_t s = 0; s < _chunkStreams.size() && chunksToLoad.size() < maxChunkCount; ++s )
+      {
+         ChunkStream& stream = _chunkStreams[s];
+         if( stream.next == stream.end || _fileChunksMinStart[stream.next] > time ) continue;
+
+         chunksToLoad.push_back( stream.next++ );
+         chunkStreams.push_back( s );
+         picked = true;
+      }
+   }
+
+   HOP_PROF_SPLIT( "Reading chunks" );
+   const size_t count = chunksToLoad.size();
+   if( _chunkBuffers.size() < count )
+   {
+      _chunkBuffers.resize( count );
+      _chunkCompressedBuffers.resize( count );
+   }
+   std::vector<uint8_t> valid( count );
+   for( size_t i = 0; i < count; ++i )
+   {
+      valid[i] = readChunk( chunksToLoad[i], _chunkCompressedBuffers[i] );
+   }
+
+   // The chunks are independent, so they can all be uncompressed at once
+   HOP_PROF_SPLIT( "Uncompressing chunks" );
+   parallelFor( count, [&]( size_t i ) {
+      if( valid[i] )
+      {
+         valid[i] = uncompressChunk(
+             _chunkCompressedBuffers[i], _fileChunks[chunksToLoad[i]].uncompressedSize, _chunkBuffers[i] );
+      }
+   } );
+
+   HOP_PROF_SPLIT( "Adding chunks" );
+   std::vector<uint8_t> failedStreams( _chunkStreams.size() );
+   for( size_t i = 0; i < count; ++i )
+   {
+      if( failedStreams[chunkStreams[i]] ) continue;
+
+      if( !valid[i] || !addChunk( _fileChunks[chunksToLoad[i]], _chunkBuffers[i].data() ) )
+      {
+         fprintf( stderr, "Could not load chunk %zu of chunked file\n", chunksToLoad[i] );
+         // Skip the rest of the stream as the following chunks cannot be appended
+         ChunkStream& stream             = _chunkStreams[chunkStreams[i]];
+         stream.next                     = stream.end;
+         failedStreams[chunkStreams[i]] = true;
+      }
+   }
+
+   // Release the file once everything was loaded
+   const bool allLoaded = std::all_of( _chunkStreams.begin(), _chunkStreams.end(), []( const ChunkStream& s ) {
+      return s.next == s.end;
+   } );
+   if( allLoaded )
+   {
+      _chunkedFile.close();
+      _fileChunks.clear();
+      _fileChunksMinStart.clear();
+      _chunkStreams.clear();
+      std::vector<std::vector<char> >().swap( _chunkBuffers );
+      std::vector<std::vector<char> >().swap( _chunkCompressedBuffers );
+   }
+
+   return count > 0;
+}
+
+bool Profiler::readChunk( size_t chunkIdx, std::vector<char>& dst )
+{
+   const ChunkInfo& chunk = _fileChunks[chunkIdx];
+   dst.resize( chunk.compressedSize );
+   _chunkedFile.seekg( chunk.offset );
+   if( !_chunkedFile.read( dst.data(), dst.size() ) )
+   {
+      fprintf( stderr, "Could not read chunk %zu of chunked file\n", chunkIdx );
+      _chunkedFile.clear();
+      return false;
+   }
+   return true;
+}
+
+bool Profiler::addChunk( const ChunkInfo& chunk, const char* src )
+{
+   HOP_PROF_FUNC();
+   switch( chunk.type )
+   {
+      case CHUNK_TYPE_METADATA:
+         addMetadata( src );
+         break;
+      case CHUNK_TYPE_TRACES:
+      {
+         TraceData traces;
+         deserialize( src, traces );
+         addTraces( std::move( traces ), chunk.trackIndex );
+         break;
+      }
+      case CHUNK_TYPE_LOCK_WAITS:
+      {
+         LockWaitData lockWaits;
+         deserialize( src, lockWaits );
+         addLockWaits( std::move( lockWaits ), chunk.trackIndex );
+         break;
+      }
+      case CHUNK_TYPE_CORE_EVENTS:
+      {
+         CoreEventData coreEvents;
+         deserialize( src, coreEvents );
+         addCoreEvents( std::move( coreEvents ), chunk.trackIndex );
+         break;
+      }
+      default:
+         fprintf( stderr, "Unknown chunk type %u\n", chunk.type );
+         return false;
+   }
+
+   return true;
+}
+
+bool Profiler::saveMappedFile( const char* savePath )
+{
+   HOP_PROF_FUNC();
+   std::ofstream of( savePath, std::ofstream::binary );
+   if( !of.is_open() ) return false;
+
+   std::vector<char> metadata;
+   serializeMetadata( metadata );
+
+   SaveFileHeader header = {MAPPED_MAGIC_NUMBER,
+                            HOP_VERSION,
+                            cpuFreqGHz(),
+                            0,
+                            (uint32_t)serializedSize( _strDb ),
+                            (uint32_t)_tracks.size()};
+   of.write( (const char*)&header, sizeof( header ) );
+   of.write( metadata.data(), metadata.size() );
+
+   // The columns are written in the order in which they are mapped back
+   std::vector<MappedTrackInfo> infos( _tracks.size() );
+   for( size_t t = 0; t < _tracks.size(); ++t )
+   {
+      const TimelineTrack& track = _tracks[t];
+      MappedTrackInfo& info      = infos[t];
+      info                       = {};
+      info.traceCount            = track._traces.entries.ends.size();
+      info.lockWaitCount         = track._lockWaits.entries.ends.size();
+      info.coreEventCount        = track._coreEvents.cores.size();
+      info.traceMaxDepth         = track._traces.entries.maxDepth;
+      info.lockWaitMaxDepth      = track._lockWaits.entries.maxDepth;
+      info.coreEventMaxDepth     = track._coreEvents.entries.maxDepth;
+
+      writeMappedColumn( of, track._traces.entries.starts, &info );
+      writeMappedColumn( of, track._traces.entries.ends, &info );
+      writeMappedColumn( of, track._traces.entries.depths, &info );
+      writeMappedColumn( of, track._traces.fileNameIds, &info );
+      writeMappedColumn( of, track._traces.fctNameIds, &info );
+      writeMappedColumn( of, track._traces.lineNbs, &info );
+      writeMappedColumn( of, track._traces.zones, &info );
+
+      writeMappedColumn( of, track._lockWaits.entries.starts, &info );
+      writeMappedColumn( of, track._lockWaits.entries.ends, &info );
+      writeMappedColumn( of, track._lockWaits.entries.depths, &info );
+      writeMappedColumn( of, track._lockWaits.mutexAddrs, &info );
+      writeMappedColumn( of, track._lockWaits.lockReleases, &info );
+
+      writeMappedColumn( of, track._coreEvents.entries.starts, &info );
+      writeMappedColumn( of, track._coreEvents.entries.ends, &info );
+      writeMappedColumn( of, track._coreEvents.entries.depths, &info );
+      writeMappedColumn( of, track._coreEvents.cores, &info );
+   }
+
+   const ChunkedFileFooter footer = {
+       (uint64_t)of.tellp(), (uint32_t)infos.size(), MAPPED_MAGIC_NUMBER};
+   of.write( (const char*)infos.data(), infos.size() * sizeof( MappedTrackInfo ) );
+   of.write( (const char*)&footer, sizeof( footer ) );
+
+   header.uncompressedSize = of.tellp();
+   of.seekp( 0 );
+   of.write( (const char*)&header, sizeof( header ) );
+
+   return of.good();
+}
+
+bool Profiler::openMappedFile( const char* path )
+{
+   HOP_PROF_FUNC();
+   uint64_t fileSize = 0;
+   char* file        = (char*)mapFile( path, &fileSize );
+   if( !file )
+   {
+      fprintf( stderr, "Could not map file %s\n", path );
+      return false;
+   }
+   _mappedFile     = file;
+   _mappedFileSize = fileSize;
+
+   ChunkedFileFooter footer;
+   memcpy( &footer, file + fileSize - sizeof( footer ), sizeof( footer ) );
+   if( fileSize < sizeof( SaveFileHeader ) + sizeof( footer ) || footer.magicNumber != MAPPED_MAGIC_NUMBER ||
+       footer.indexOffset + footer.chunkCount * sizeof( MappedTrackInfo ) + sizeof( footer ) != fileSize )
+   {
+      fprintf( stderr, "Mapped file has no valid index\n" );
+      clear();
+      return false;
+   }
+
+   addMetadata( file + sizeof( SaveFileHeader ) );
+
+   // Hand the mapped columns to the tracks. Since the tracks are empty, the blocks
+   // are used as is and nothing is copied.
+   bool valid = footer.chunkCount == _tracks.size();
+   const MappedTrackInfo* infos = (const MappedTrackInfo*)( file + footer.indexOffset );
+   for( uint32_t t = 0; t < footer.chunkCount && valid; ++t )
+   {
+      const MappedTrackInfo& info = infos[t];
+      uint32_t col = 0;
+      valid = info.columnCount == sizeof( info.columnOffsets ) / sizeof( info.columnOffsets[0] );
+
+      TraceData traces;
+      traces.entries.maxDepth = info.traceMaxDepth;
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.entries.starts );
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.entries.ends );
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.entries.depths );
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.fileNameIds );
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.fctNameIds );
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.lineNbs );
+      valid = valid && mapColumn( file, fileSize, info.traceCount, info, &col, traces.zones );
+
+      LockWaitData lockWaits;
+      lockWaits.entries.maxDepth = info.lockWaitMaxDepth;
+      valid = valid && mapColumn( file, fileSize, info.lockWaitCount, info, &col, lockWaits.entries.starts );
+      valid = valid && mapColumn( file, fileSize, info.lockWaitCount, info, &col, lockWaits.entries.ends );
+      valid = valid && mapColumn( file, fileSize, info.lockWaitCount, info, &col, lockWaits.entries.depths );
+      valid = valid && mapColumn( file, fileSize, info.lockWaitCount, info, &col, lockWaits.mutexAddrs );
+      valid = valid && mapColumn( file, fileSize, info.lockWaitCount, info, &col, lockWaits.lockReleases );
+
+      CoreEventData coreEvents;
+      coreEvents.entries.maxDepth = info.coreEventMaxDepth;
+      valid = valid && mapColumn( file, fileSize, info.coreEventCount, info, &col, coreEvents.entries.starts );
+      valid = valid && mapColumn( file, fileSize, info.coreEventCount, info, &col, coreEvents.entries.ends );
+      valid = valid && mapColumn( file, fileSize, info.coreEventCount, info, &col, coreEvents.entries.depths );
+      valid = valid && mapColumn( file, fileSize, info.coreEventCount, info, &col, coreEvents.cores );
+
+      if( valid )
+      {
+         addTraces( std::move( traces ), t );
+         addLockWaits( std::move( lockWaits ), t );
+         addCoreEvents( std::move( coreEvents ), t );
+      }
+   }
+
+   if( !valid )
+   {
+      fprintf( stderr, "Mapped file %s is corrupted\n", path );
+      clear();
+      return false;
+   }
+
+   _srcType = SRC_TYPE_FILE;
+
+   return true;
+}
+
+bool Profiler::startStreaming( const char* path )
+{
+   stopStreaming();
+
+   _streamFile.open( path, std::ofstream::binary | std::ofstream::trunc );
+   if( !_streamFile.is_open() ) return false;
+
+   SaveFileHeader header = {STREAM_MAGIC_NUMBER, HOP_VERSION, cpuFreqGHz(), 0, 0, 0};
+   _streamFile.write( (const char*)&header, sizeof( header ) );
+   _streamFile.flush();
+
+   _streamPath         = path;
+   _streamedTraceCount = 0;
+   _lastStreamFlush    = std::chrono::steady_clock::now();
+
+   return _streamFile.good();
+}
+
+bool Profiler::stopStreaming()
+{
+   if( !_streamFile.is_open() ) return true;
+
+   const bool success = flushStreamChunk();
+   _streamFile.close();
+
+   // Give back the memory of the buffers
+   std::vector<char>().swap( _streamBuffer );
+   std::vector<char>().swap( _streamCompressedBuffer );
+
+   return success;
+}
+
+bool Profiler::streaming() const
+{
+   return _streamFile.is_open();
+}
+
+bool Profiler::streamPendingData( Server::PendingData& pendingData )
+{
+   HOP_PROF_FUNC();
+
+   // Only keep the data that is sent once when we are not recording
+   if( !_recording )
+   {
+      for( auto& traces : pendingData.tracesPerThread ) traces.second.clear();
+      for( auto& lockwaits : pendingData.lockWaitsPerThread ) lockwaits.second.clear();
+      for( auto& unlockEvents : pendingData.unlockEventsPerThread ) unlockEvents.second.clear();
+      for( auto& coreEvents : pendingData.coreEventsPerThread ) coreEvents.second.clear();
+   }
+
+   size_t traceCount = 0;
+   for( const auto& traces : pendingData.tracesPerThread )
+   {
+      traceCount += traces.second.entries.ends.size();
+   }
+   _streamedTraceCount += traceCount;
+
+   const size_t prevSize = _streamBuffer.size();
+   _streamBuffer.resize( prevSize + serializedSize( pendingData ) );
+   serialize( pendingData, &_streamBuffer[prevSize] );
+
+   return traceCount > 0 || !pendingData.threadNames.empty();
+}
+
+bool Profiler::flushStreamChunk()
+{
+   HOP_PROF_FUNC();
+   _lastStreamFlush = std::chrono::steady_clock::now();
+   if( _streamBuffer.empty() ) return true;
+
+   mz_ulong compressedSize = compressBound( _streamBuffer.size() );
+   _streamCompressedBuffer.resize( compressedSize );
+   const int compressionStatus = compress2(
+       (unsigned char*)_streamCompressedBuffer.data(),
+       &compressedSize,
+       (const unsigned char*)_streamBuffer.data(),
+       _streamBuffer.size(),
+       Z_BEST_SPEED );
+   if( compressionStatus != Z_OK )
+   {
+      fprintf( stderr, "Compression failed. Chunk not written to %s\n", _streamPath.c_str() );
+      _streamBuffer.clear();
+      return false;
+   }
+
+   // Write the whole chunk before flushing it so that a partially written chunk can
+   // only be found at the end of the file
+   StreamChunkHeader header = {
+       CHUNK_MAGIC_NUMBER, cpuFreqGHz(), _streamBuffer.size(), compressedSize};
+   _streamFile.write( (const char*)&header, sizeof( header ) );
+   _streamFile.write( _streamCompressedBuffer.data(), compressedSize );
+   _streamFile.flush();
+   _streamBuffer.clear();
+
+   if( !_streamFile.good() )
+   {
+      fprintf( stderr, "Failed to write chunk to %s\n", _streamPath.c_str() );
+      return false;
+   }
+   return true;
+}
+
 void Profiler::clear()
 {
    _server.clear();
    _strDb.clear();
    _tracks.clear();
    _recording = false;
+
+   // Drop what remains of a lazily opened file
+   _chunkedFile.close();
+   _fileChunks.clear();
+   _fileChunksMinStart.clear();
+   _chunkStreams.clear();
+
+   // The tracks do not use the mapped file anymore
+   if( _mappedFile )
+   {
+      unmapFile( _mappedFile, _mappedFileSize );
+      _mappedFile     = nullptr;
+      _mappedFileSize = 0;
+   }
+
+   // Start over with an empty stream file
+   if( _streamFile.is_open() )
+   {
+      _streamBuffer.clear();
+      const std::string path = _streamPath;
+      _streamFile.close();
+      startStreaming( path.c_str() );
+   }
 }
 
-Profiler::~Profiler() { _server.stop(); }
+Profiler::~Profiler()
+{
+   _server.stop();
+   stopStreaming();
+
+   if( _mappedFile )
+   {
+      _tracks.clear();
+      unmapFile( _mappedFile, _mappedFileSize );
+   }
+}
 
 }  // namespace hop
\ No newline at end of file
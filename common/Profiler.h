@@ -5,6 +5,8 @@
 #include "common/StringDb.h"
 #include "common/TimelineTrack.h"
 
+#include <chrono>
+#include <fstream>
 #include <string>
 
 namespace hop
@@ -15,6 +17,9 @@ struct ProfilerStats
    size_t strDbSize;
    size_t traceCount;
    size_t clientSharedMemSize;
+   size_t droppedMsgCount;
+   size_t droppedTraceCount;
+   std::vector<Server::DroppedData> droppedPerThread;
 };
 
 class Profiler
@@ -44,17 +49,68 @@ public:
    void setRecording( bool recording );
    bool fetchClientData();
    bool addStringData( const std::vector< char >& stringData );
-   bool addTraces( const TraceData& traces, uint32_t threadIndex );
-   bool addLockWaits( const LockWaitData& lockWaits, uint32_t threadIndex);
+   bool addTraces( TraceData&& traces, uint32_t threadIndex );
+   bool addLockWaits( LockWaitData&& lockWaits, uint32_t threadIndex);
    bool addUnlockEvents(const std::vector<UnlockEvent>& unlockEvents, uint32_t threadIndex);
-   bool addCoreEvents( const CoreEventData& coreEvents, uint32_t threadIndex );
+   bool addCoreEvents( CoreEventData&& coreEvents, uint32_t threadIndex );
    void addThreadName( StrPtr_t name, uint32_t threadIndex );
    void clear();
 
-   bool saveToFile( const char* path );
+   // A mappable file is not compressed, but it is used in place when opened instead
+   // of being loaded in memory
+   bool saveToFile( const char* path, bool mappable = false );
    bool openFile( const char* path );
 
+   // Files saved in chunks are opened lazily. Load the chunks of each track that
+   // start before time. Returns true if new data was loaded.
+   bool loadChunksUntil( TimeStamp time );
+   // Load all the chunks remaining, for the queries over the whole capture
+   void loadAllChunks();
+   bool fullyLoaded() const;
+
+   // Stream the recording to the file at path as it is received instead of keeping
+   // it in memory. The data is appended in compressed chunks, so the file can be
+   // opened even if the recorder is killed while recording.
+   bool startStreaming( const char* path );
+   bool stopStreaming();
+   bool streaming() const;
+
 private:
+   bool addPendingData( Server::PendingData& pendingData, bool recording );
+   bool streamPendingData( Server::PendingData& pendingData );
+   bool flushStreamChunk();
+   bool openStreamedFile( std::ifstream& input );
+   bool openChunkedFile( std::ifstream& input );
+   bool openMappedFile( const char* path );
+   bool saveChunkedFile( const char* path, size_t batchSize );
+   bool saveMappedFile( const char* path );
+   void serializeMetadata( std::vector<char>& dst ) const;
+   void addMetadata( const char* src );
+   bool loadChunks( TimeStamp time, size_t maxChunkCount );
+
+   // Location of a compressed chunk in a chunked file, along with the time range it covers
+   struct ChunkInfo
+   {
+      uint64_t offset;
+      uint64_t compressedSize;
+      uint64_t uncompressedSize;
+      TimeStamp start;
+      TimeStamp end;
+      uint32_t trackIndex;
+      uint32_t type;
+   };
+
+   // Consecutive chunks of the same data type of a track. They are loaded in order
+   // as the tracks can only be appended to.
+   struct ChunkStream
+   {
+      size_t next;
+      size_t end;
+   };
+
+   bool readChunk( size_t chunkIdx, std::vector<char>& dst );
+   bool addChunk( const ChunkInfo& chunk, const char* src );
+
    std::string _name;
    std::vector<TimelineTrack> _tracks;
    StringDb _strDb;
@@ -67,6 +123,26 @@ private:
 
    TimeStamp _earliestTimeStamp;
    TimeStamp _latestTimeStamp;
+
+   // Serialized batches waiting to be compressed and written to the stream file
+   std::ofstream _streamFile;
+   std::string _streamPath;
+   std::vector<char> _streamBuffer;
+   std::vector<char> _streamCompressedBuffer;
+   std::chrono::steady_clock::time_point _lastStreamFlush;
+   size_t _streamedTraceCount{0};
+
+   // Chunks of the lazily opened file that remain to be loaded
+   std::ifstream _chunkedFile;
+   std::vector<ChunkInfo> _fileChunks;
+   std::vector<TimeStamp> _fileChunksMinStart; // Earliest start of the chunk and the following ones of its stream
+   std::vector<ChunkStream> _chunkStreams;
+   std::vector<std::vector<char> > _chunkBuffers;
+   std::vector<std::vector<char> > _chunkCompressedBuffers;
+
+   // File mapped in memory whose blocks are used by the tracks
+   void* _mappedFile{nullptr};
+   uint64_t _mappedFileSize{0};
 };
 
 }  // namespace hop
@@ -11,6 +11,12 @@
 #include <chrono>
 
 static constexpr int POLL_COUNT_FAIL_DISCONNECTION = 20;
+// Number of consecutive empty polls before parking until a producer wakes us up
+static constexpr int POLL_COUNT_BEFORE_PARKING = 2;
+// Parking timeout, so that the state and the connection are still checked regularly
+static constexpr uint32_t PARKING_TIMEOUT_MS = 50;
+// The callsite ids come from the client, so they are bounded before being used as indices
+static constexpr uint32_t MAX_CALLSITE_COUNT = 1u << 24;
 
 template <typename T, class BinaryPredicate, class MergeFct>
 static T merge_consecutive( T first, T last, BinaryPredicate pred, MergeFct merge )
@@ -137,8 +143,11 @@ bool Server::start( int inPid, const char* name )
             {
                _stringDb.clear();
                clearPendingMessages();
+               _pendingData.clear();
+               _hasUnpublishedData      = false;
                _state.clearingRequested = false;
                _sharedMem.setResetTimestamp( getTimeStamp() );
+               _sharedMem.resetDropCounters();
                _threadNamesReceived.clear();
                continue;
             }
@@ -158,23 +167,24 @@ bool Server::start( int inPid, const char* name )
             }
          }
 
-         size_t offset = 0;
-         const size_t bytesToRead = ringbuf_consume( _sharedMem.ringbuffer(), &offset );
-         if ( bytesToRead > 0 )
+         // The producers seem idle. Signal them we are about to park before polling
+         // one last time so that we cannot miss their wakeup
+         const bool parking = clientAlive && pollFailedCount >= POLL_COUNT_BEFORE_PARKING &&
+                              _sharedMem.canParkConsumer();
+         if( parking ) _sharedMem.parkConsumer();
+
+         if ( consumeMessages() > 0 )
          {
-            HOP_PROF( "Server - Handling new messages" );
+            if( parking ) _sharedMem.unparkConsumer();
             pollFailedCount = 0;
-            const TimeStamp minTimestamp = _sharedMem.lastResetTimestamp();
-            size_t bytesRead = 0;
-            while ( bytesRead < bytesToRead )
-            {
-               bytesRead += handleNewMessage(
-                   &_sharedMem.data()[offset + bytesRead], bytesToRead - bytesRead, minTimestamp );
-            }
-            ringbuf_release( _sharedMem.ringbuffer(), bytesToRead );
+            _hasUnpublishedData = true;
+            publishPendingData();
          }
          else
          {
+            // Publish what could not be pushed previously as the queue was full
+            publishPendingData();
+
             // Nothing was sent
             ++pollFailedCount;
             HOP_PROF( "Nothing send..." );
@@ -183,7 +193,16 @@ bool Server::start( int inPid, const char* name )
             // not very productive or is being debuged. If we do not have a producer, it means the
             // app was closed.
             using namespace std::chrono;
-            if( clientAlive )
+            if( parking )
+            {
+               _sharedMem.waitForProducer( PARKING_TIMEOUT_MS );
+            }
+            else if( clientAlive && _sharedMem.canParkConsumer() )
+            {
+               // We will soon be parked, keep polling until then
+               std::this_thread::yield();
+            }
+            else if( clientAlive )
             {
                // Relax our polling after a few attemps
                std::this_thread::sleep_for( microseconds( 500 ) * std::min( pollFailedCount, 10 ) );
@@ -305,6 +324,22 @@ size_t Server::sharedMemorySize() const
    return 0;
 }
 
+void Server::droppedData( std::vector<DroppedData>& perThread ) const
+{
+   perThread.clear();
+   if( _sharedMem.valid() )
+   {
+      const uint32_t threadCount = _sharedMem.sharedMetaInfo()->maxThreadNb;
+      const SharedMemory::DropCounters* counters = _sharedMem.dropCounters();
+      perThread.resize( threadCount );
+      for( uint32_t i = 0; i < threadCount; ++i )
+      {
+         perThread[i].msgCount   = counters[i].droppedMsgCount.load();
+         perThread[i].traceCount = counters[i].droppedTraceCount.load();
+      }
+   }
+}
+
 float Server::cpuFreqGHz() const
 {
    if( _cpuFreqGHz == 0 && _sharedMem.valid() )
@@ -333,12 +368,25 @@ void Server::setRecording( bool recording )
    }
 }
 
-void Server::getPendingData( PendingData& data )
+bool Server::getPendingData( PendingData& data )
 {
    HOP_PROF_FUNC();
-   std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
-   _sharedPendingData.swap( data );
-   _sharedPendingData.clear();
+   // The previous batch goes back to the server thread through the queue. Clear
+   // it here so the server thread does not have to.
+   data.clear();
+   return _pendingDataQueue.pop( data );
+}
+
+void Server::publishPendingData()
+{
+   // If the queue is full, keep accumulating the data in the current batch. It
+   // will be published once the consumer catches up. On success, we get back
+   // an empty batch that was already consumed.
+   if( _hasUnpublishedData && _pendingDataQueue.push( _pendingData ) )
+   {
+      _hasUnpublishedData = false;
+      wakeUpMainLoop();
+   }
 }
 
 bool Server::addUniqueThreadName( uint32_t threadIndex, StrPtr_t name )
@@ -358,6 +406,56 @@ bool Server::addUniqueThreadName( uint32_t threadIndex, StrPtr_t name )
    return newInsert;
 }
 
+size_t Server::consumeMessages()
+{
+   const TimeStamp minTimestamp = _sharedMem.lastResetTimestamp();
+   const uint32_t channelCount  = _sharedMem.channelCount();
+
+   size_t totalBytesRead = 0;
+   if( channelCount == 0 )
+   {
+      // All the threads share the same ring buffer
+      size_t offset = 0;
+      const size_t bytesToRead = ringbuf_consume( _sharedMem.ringbuffer(), &offset );
+      if ( bytesToRead > 0 )
+      {
+         HOP_PROF( "Server - Handling new messages" );
+         handleNewMessages( &_sharedMem.data()[offset], bytesToRead, minTimestamp );
+         ringbuf_release( _sharedMem.ringbuffer(), bytesToRead );
+         totalBytesRead = bytesToRead;
+      }
+   }
+   else
+   {
+      // Each thread has its own channel. Consume a single range from each of them
+      // in turn so a busy thread cannot starve the others
+      for( uint32_t i = 0; i < channelCount; ++i )
+      {
+         spscbuf_t* channel = _sharedMem.channel( i );
+         size_t offset = 0;
+         const size_t bytesToRead = spscbuf_consume( channel, &offset );
+         if ( bytesToRead > 0 )
+         {
+            HOP_PROF( "Server - Handling new channel messages" );
+            handleNewMessages( &spscbuf_data( channel )[offset], bytesToRead, minTimestamp );
+            spscbuf_release( channel, bytesToRead );
+            totalBytesRead += bytesToRead;
+         }
+      }
+   }
+
+   return totalBytesRead;
+}
+
+void Server::handleNewMessages( uint8_t* data, size_t size, TimeStamp minTimestamp )
+{
+   size_t bytesRead = 0;
+   while ( bytesRead < size )
+   {
+      bytesRead += handleNewMessage( &data[bytesRead], size - bytesRead, minTimestamp );
+   }
+}
+
 size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTimestamp )
 {
    uint8_t* bufPtr = data;
@@ -375,8 +473,7 @@ size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTim
    // If the thread has an assigned name
    if ( msgInfo->threadName != 0 && addUniqueThreadName( threadIndex, msgInfo->threadName ) )
    {
-      std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
-      _sharedPendingData.threadNames.emplace_back( threadIndex, msgInfo->threadName );
+      _pendingData.threadNames.emplace_back( threadIndex, msgInfo->threadName );
     }
 
     switch ( msgType )
@@ -391,58 +488,110 @@ size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTim
              bufPtr += strSize;
              assert( ( size_t )( bufPtr - data ) <= maxSize );
 
-             // TODO: Could lock later when we received all the messages
-             std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
              _stringDb.addStringData( strDataPtr, strSize );
-             _sharedPendingData.stringData.insert(
-                 _sharedPendingData.stringData.end(), strDataPtr, strDataPtr + strSize );
+             _pendingData.stringData.insert(
+                 _pendingData.stringData.end(), strDataPtr, strDataPtr + strSize );
           }
           return ( size_t )( bufPtr - data );
        }
        case MsgType::PROFILER_TRACE:
        {
           const size_t tracesCount = msgInfo->traces.count;
+          if ( msgInfo->traces.encoding != TraceEncoding::COMPACT_V1 )
+          {
+             fprintf(
+                 stderr,
+                 "Unknown traces encoding %u. The traces will be ignored\n",
+                 (uint32_t)msgInfo->traces.encoding );
+             return maxSize;
+          }
+
+          const CompactTracesHeader* header = (const CompactTracesHeader*)bufPtr;
+          bufPtr += sizeof( CompactTracesHeader );
+
+          // Register the callsites used for the first time by this thread. The ids
+          // are shared by all the threads of the client.
+          const CallsiteInfo* newCallsites = (const CallsiteInfo*)bufPtr;
+          for ( uint32_t i = 0; i < header->newCallsiteCount; ++i )
+          {
+             const CallsiteInfo& info = newCallsites[i];
+             if ( info.id >= MAX_CALLSITE_COUNT )
+             {
+                fprintf( stderr, "Invalid callsite id %u. The traces will be ignored\n", info.id );
+                return maxSize;
+             }
+             if ( _callsites.size() <= info.id )
+             {
+                _callsites.resize( info.id + 1 );
+             }
+             _callsites[info.id] = Callsite{ _stringDb.getStringIndex( info.fileName ),
+                                             _stringDb.getStringIndex( info.fctName ),
+                                             info.lineNb };
+          }
+          bufPtr += header->newCallsiteCount * sizeof( CallsiteInfo );
+
+          // The encoded traces are followed by the padding added by the client to keep
+          // the messages 8 bytes aligned
+          const uint8_t* encodedTraces = bufPtr;
+          bufPtr += header->encodedSize;
+          bufPtr = data + ( ( ( size_t )( bufPtr - data ) + 7 ) & ~( size_t )7 );
+          assert( ( size_t )( bufPtr - data ) <= maxSize );
+
           if ( tracesCount > 0 )
           {
-             TraceData traceData;
-             const TimeStamp* starts = (const TimeStamp*)bufPtr;
-             const TimeStamp* ends = starts + tracesCount;
-             const StrPtr_t* fileNames = (const StrPtr_t*)( ends + tracesCount );
-             const StrPtr_t* fctNames = fileNames + tracesCount;
-             const LineNb_t* lineNbs = (const LineNb_t*)( fctNames + tracesCount );
-             const Depth_t* depths = (const Depth_t*)( lineNbs + tracesCount );
-             const ZoneId_t* zones = (const ZoneId_t*)( depths + tracesCount );
-
-             traceData.entries.ends.append( ends, ends + tracesCount );
-             traceData.entries.starts.append( starts, starts + tracesCount );
-             traceData.entries.depths.append( depths, depths + tracesCount );
-             traceData.entries.maxDepth = *std::max_element( depths, depths + tracesCount );
-
-             traceData.lineNbs.append( lineNbs, lineNbs + tracesCount );
-             traceData.zones.append( zones, zones + tracesCount );
-
-             // Process non trivially copiable members
+             // Decode straight into the thread's staging data. It will be handed
+             // over as a whole to the profiler once the batch is published.
+             TraceData& traceData = _pendingData.tracesPerThread[threadIndex];
+             const size_t prevCount = traceData.entries.ends.size();
+             const uint8_t* in = encodedTraces;
+             TimeStamp prevEnd = 0;
+             Depth_t maxDepth = traceData.entries.maxDepth;
              for ( size_t i = 0; i < tracesCount; ++i )
              {
-                traceData.fileNameIds.push_back( _stringDb.getStringIndex( fileNames[i] ) );
-                traceData.fctNameIds.push_back( _stringDb.getStringIndex( fctNames[i] ) );
+                uint64_t endDelta, duration, callsiteId, depth, zone;
+                in += decodeVarint( in, &endDelta );
+                in += decodeVarint( in, &duration );
+                in += decodeVarint( in, &callsiteId );
+                in += decodeVarint( in, &depth );
+                in += decodeVarint( in, &zone );
+
+                // The callsite info may have been dropped with its message, or cleared
+                // since. Remove the traces of the message decoded so far and skip it.
+                if ( callsiteId >= _callsites.size() )
+                {
+                   fprintf(
+                       stderr,
+                       "Unknown callsite id %" PRIu64 ". The traces will be ignored\n",
+                       callsiteId );
+                   const size_t decodedCount = traceData.entries.ends.size() - prevCount;
+                   traceData.entries.ends.pop_back( decodedCount );
+                   traceData.entries.starts.pop_back( decodedCount );
+                   traceData.entries.depths.pop_back( decodedCount );
+                   traceData.zones.pop_back( decodedCount );
+                   traceData.fileNameIds.pop_back( decodedCount );
+                   traceData.fctNameIds.pop_back( decodedCount );
+                   traceData.lineNbs.pop_back( decodedCount );
+                   return ( size_t )( bufPtr - data );
+                }
+
+                const TimeStamp end = prevEnd + zigzagDecode( endDelta );
+                traceData.entries.ends.push_back( end );
+                traceData.entries.starts.push_back( end - zigzagDecode( duration ) );
+                traceData.entries.depths.push_back( (Depth_t)depth );
+                traceData.zones.push_back( (ZoneId_t)zone );
+                maxDepth = std::max( maxDepth, (Depth_t)depth );
+                prevEnd = end;
+
+                const Callsite& callsite = _callsites[callsiteId];
+                traceData.fileNameIds.push_back( callsite.fileNameId );
+                traceData.fctNameIds.push_back( callsite.fctNameId );
+                traceData.lineNbs.push_back( callsite.lineNb );
              }
+             traceData.entries.maxDepth = maxDepth;
+             assert( in == encodedTraces + header->encodedSize );
 
              // The ends time should already be sorted
              assert_is_sorted( traceData.entries.ends.begin(), traceData.entries.ends.end() );
-
-             bufPtr +=
-                 ( ( sizeof( TimeStamp ) + sizeof( TimeStamp ) + sizeof( Depth_t ) +
-                     sizeof( StrPtr_t ) + sizeof( StrPtr_t ) + sizeof( LineNb_t ) +
-                     sizeof( ZoneId_t ) ) *
-                   tracesCount );
-             assert( ( size_t )( bufPtr - data ) <= maxSize );
-
-             static_assert(
-                 std::is_move_constructible<TraceData>::value, "Trace Data not moveable" );
-             // TODO: Could lock later when we received all the messages
-             std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
-             _sharedPendingData.tracesPerThread[threadIndex].append( traceData );
           }
           return ( size_t )( bufPtr - data );
        }
@@ -468,9 +617,7 @@ size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTim
          // The ends time should already be sorted
          assert_is_sorted( lockwaitData.entries.ends.begin(), lockwaitData.entries.ends.end() );
 
-         // TODO: Could lock later when we received all the messages
-         std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
-         _sharedPendingData.lockWaitsPerThread[threadIndex].append( lockwaitData );
+         _pendingData.lockWaitsPerThread[threadIndex].append( lockwaitData );
 
          return ( size_t )( bufPtr - data );
       }
@@ -487,9 +634,7 @@ size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTim
                 return lhs.time < rhs.time;
              } );
 
-         // TODO: Could lock later when we received all the messages
-         std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
-         auto& unlocks = _sharedPendingData.unlockEventsPerThread[threadIndex];
+         auto& unlocks = _pendingData.unlockEventsPerThread[threadIndex];
          unlocks.insert( unlocks.end(), eventPtr, eventPtr + eventCount );
 
          return ( size_t )( bufPtr - data );
@@ -518,9 +663,7 @@ size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTim
          }
          coresData.entries.depths.append( newCount, 0 );
 
-         // TODO: Could lock later when we received all the messages
-         std::lock_guard<hop::Mutex> guard( _sharedPendingDataMutex );
-         _sharedPendingData.coreEventsPerThread[threadIndex].append( coresData );
+         _pendingData.coreEventsPerThread[threadIndex].append( coresData );
          return ( size_t )( bufPtr - data );
       }
       default:
@@ -531,17 +674,34 @@ size_t Server::handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTim
 
 void Server::clearPendingMessages()
 {
+   // The callsites are sent again once the clients reset their string data
+   _callsites.clear();
+
    size_t offset = 0;
    while ( size_t bytesToRead = ringbuf_consume( _sharedMem.ringbuffer(), &offset ) )
    {
       ringbuf_release( _sharedMem.ringbuffer(), bytesToRead );
    }
+
+   for( uint32_t i = 0; i < _sharedMem.channelCount(); ++i )
+   {
+      spscbuf_t* channel = _sharedMem.channel( i );
+      while ( size_t bytesToRead = spscbuf_consume( channel, &offset ) )
+      {
+         spscbuf_release( channel, bytesToRead );
+      }
+   }
 }
 
 void Server::clear()
 {
    setRecording( false );
 
+   // Drop the batches that were already published. This must be called from
+   // the thread consuming the pending data.
+   PendingData discarded;
+   while ( getPendingData( discarded ) ) {}
+
    std::lock_guard<hop::Mutex> guard( _stateMutex );
    _state.clearingRequested = true;
 }
@@ -614,4 +774,190 @@ void Server::PendingData::swap( PendingData& rhs )
    swap( threadNames, rhs.threadNames );
 }
 
+template <typename T>
+static size_t writeValue( const T& value, char* dst )
+{
+   memcpy( dst, &value, sizeof( T ) );
+   return sizeof( T );
+}
+
+template <typename T>
+static size_t readValue( const char* src, T* value )
+{
+   memcpy( value, src, sizeof( T ) );
+   return sizeof( T );
+}
+
+template <typename T>
+static uint32_t nonEmptyCount( const std::unordered_map<uint32_t, T>& perThread )
+{
+   uint32_t count = 0;
+   for( const auto& data : perThread )
+      count += data.second.entries.ends.empty() ? 0 : 1;
+   return count;
+}
+
+size_t serializedSize( const Server::PendingData& pd )
+{
+   size_t size = sizeof( uint64_t ) + pd.stringData.size();
+
+   size += sizeof( uint32_t );
+   for( const auto& traces : pd.tracesPerThread )
+   {
+      if( !traces.second.entries.ends.empty() )
+         size += sizeof( uint32_t ) + serializedSize( traces.second );
+   }
+
+   size += sizeof( uint32_t );
+   for( const auto& lockwaits : pd.lockWaitsPerThread )
+   {
+      if( !lockwaits.second.entries.ends.empty() )
+         size += sizeof( uint32_t ) + serializedSize( lockwaits.second );
+   }
+
+   size += sizeof( uint32_t );
+   for( const auto& unlockEvents : pd.unlockEventsPerThread )
+   {
+      if( !unlockEvents.second.empty() )
+         size += 2 * sizeof( uint32_t ) + unlockEvents.second.size() * sizeof( UnlockEvent );
+   }
+
+   size += sizeof( uint32_t );
+   for( const auto& coreEvents : pd.coreEventsPerThread )
+   {
+      if( !coreEvents.second.entries.ends.empty() )
+         size += sizeof( uint32_t ) + serializedSize( coreEvents.second );
+   }
+
+   size += sizeof( uint32_t ) + pd.threadNames.size() * ( sizeof( uint32_t ) + sizeof( StrPtr_t ) );
+
+   return size;
+}
+
+size_t serialize( const Server::PendingData& pd, char* dst )
+{
+   size_t i = 0;
+
+   // String data
+   i += writeValue( (uint64_t)pd.stringData.size(), &dst[i] );
+   memcpy( &dst[i], pd.stringData.data(), pd.stringData.size() );
+   i += pd.stringData.size();
+
+   // Traces
+   i += writeValue( nonEmptyCount( pd.tracesPerThread ), &dst[i] );
+   for( const auto& traces : pd.tracesPerThread )
+   {
+      if( traces.second.entries.ends.empty() ) continue;
+      i += writeValue( traces.first, &dst[i] );
+      i += serialize( traces.second, &dst[i] );
+   }
+
+   // Lock waits
+   i += writeValue( nonEmptyCount( pd.lockWaitsPerThread ), &dst[i] );
+   for( const auto& lockwaits : pd.lockWaitsPerThread )
+   {
+      if( lockwaits.second.entries.ends.empty() ) continue;
+      i += writeValue( lockwaits.first, &dst[i] );
+      i += serialize( lockwaits.second, &dst[i] );
+   }
+
+   // Unlock events
+   uint32_t unlockThreadCount = 0;
+   for( const auto& unlockEvents : pd.unlockEventsPerThread )
+      unlockThreadCount += unlockEvents.second.empty() ? 0 : 1;
+   i += writeValue( unlockThreadCount, &dst[i] );
+   for( const auto& unlockEvents : pd.unlockEventsPerThread )
+   {
+      if( unlockEvents.second.empty() ) continue;
+      i += writeValue( unlockEvents.first, &dst[i] );
+      i += writeValue( (uint32_t)unlockEvents.second.size(), &dst[i] );
+      const size_t eventsSize = unlockEvents.second.size() * sizeof( UnlockEvent );
+      memcpy( &dst[i], unlockEvents.second.data(), eventsSize );
+      i += eventsSize;
+   }
+
+   // Core events
+   i += writeValue( nonEmptyCount( pd.coreEventsPerThread ), &dst[i] );
+   for( const auto& coreEvents : pd.coreEventsPerThread )
+   {
+      if( coreEvents.second.entries.ends.empty() ) continue;
+      i += writeValue( coreEvents.first, &dst[i] );
+      i += serialize( coreEvents.second, &dst[i] );
+   }
+
+   // Thread names
+   i += writeValue( (uint32_t)pd.threadNames.size(), &dst[i] );
+   for( const auto& threadName : pd.threadNames )
+   {
+      i += writeValue( threadName.first, &dst[i] );
+      i += writeValue( threadName.second, &dst[i] );
+   }
+
+   assert( i == serializedSize( pd ) );
+
+   return i;
+}
+
+size_t deserialize( const char* src, Server::PendingData& pd )
+{
+   size_t i = 0;
+   uint32_t count, threadIndex;
+
+   // String data
+   uint64_t stringDataSize;
+   i += readValue( &src[i], &stringDataSize );
+   pd.stringData.insert( pd.stringData.end(), &src[i], &src[i] + stringDataSize );
+   i += stringDataSize;
+
+   // Traces
+   i += readValue( &src[i], &count );
+   for( uint32_t j = 0; j < count; ++j )
+   {
+      i += readValue( &src[i], &threadIndex );
+      i += deserialize( &src[i], pd.tracesPerThread[threadIndex] );
+   }
+
+   // Lock waits
+   i += readValue( &src[i], &count );
+   for( uint32_t j = 0; j < count; ++j )
+   {
+      i += readValue( &src[i], &threadIndex );
+      i += deserialize( &src[i], pd.lockWaitsPerThread[threadIndex] );
+   }
+
+   // Unlock events
+   i += readValue( &src[i], &count );
+   for( uint32_t j = 0; j < count; ++j )
+   {
+      uint32_t eventCount;
+      i += readValue( &src[i], &threadIndex );
+      i += readValue( &src[i], &eventCount );
+      std::vector<UnlockEvent>& unlockEvents = pd.unlockEventsPerThread[threadIndex];
+      const size_t prevCount = unlockEvents.size();
+      unlockEvents.resize( prevCount + eventCount );
+      memcpy( &unlockEvents[prevCount], &src[i], eventCount * sizeof( UnlockEvent ) );
+      i += eventCount * sizeof( UnlockEvent );
+   }
+
+   // Core events
+   i += readValue( &src[i], &count );
+   for( uint32_t j = 0; j < count; ++j )
+   {
+      i += readValue( &src[i], &threadIndex );
+      i += deserialize( &src[i], pd.coreEventsPerThread[threadIndex] );
+   }
+
+   // Thread names
+   i += readValue( &src[i], &count );
+   for( uint32_t j = 0; j < count; ++j )
+   {
+      StrPtr_t name;
+      i += readValue( &src[i], &threadIndex );
+      i += readValue( &src[i], &name );
+      pd.threadNames.emplace_back( threadIndex, name );
+   }
+
+   return i;
+}
+
 }  // namespace hop
@@ -5,6 +5,7 @@
 #include <Hop.h>
 
 #include "common/Mutex.h"
+#include "common/SpscQueue.h"
 #include "common/StringDb.h"
 #include "common/TraceData.h"
 
@@ -28,6 +29,15 @@ class Server
    size_t sharedMemorySize() const;
    float cpuFreqGHz() const;
 
+   // Data the client threads had to drop because the shared memory was full.
+   // The vector is indexed by thread index.
+   struct DroppedData
+   {
+      uint32_t msgCount;
+      uint32_t traceCount;
+   };
+   void droppedData( std::vector<DroppedData>& perThread ) const;
+
    struct PendingData
    {
        std::vector<char> stringData;
@@ -42,17 +52,25 @@ class Server
        void swap(PendingData& rhs);
    };
 
-   void getPendingData(PendingData& data);
+   // Get the next batch of data received from the client. The batches are published
+   // by the server thread and must all be consumed by the same thread.
+   // Returns false if there is no batch available.
+   bool getPendingData(PendingData& data);
 
   private:
    // Return wether or not we should retry to connect and fill the connection state
    bool tryConnect( int32_t pid, SharedMemory::ConnectionState& newState );
 
+   // Consume the messages available in the shared memory. Returns the number of bytes processed
+   size_t consumeMessages();
+   void handleNewMessages( uint8_t* data, size_t size, TimeStamp minTimestamp );
+
    // Returns the number of bytes processed
    size_t handleNewMessage( uint8_t* data, size_t maxSize, TimeStamp minTimestamp );
    bool addUniqueThreadName( uint32_t threadIndex, StrPtr_t name );
 
    void clearPendingMessages();
+   void publishPendingData();
 
    std::thread _thread;
    SharedMemory _sharedMem;
@@ -71,11 +89,28 @@ class Server
       bool clearingRequested{false};
    } _state;
 
-   hop::Mutex _sharedPendingDataMutex;
-   PendingData _sharedPendingData;
+   // Data received since the last published batch. Only used by the server thread
+   PendingData _pendingData;
+   bool _hasUnpublishedData{false};
+   SpscQueue< PendingData, 8 > _pendingDataQueue;
    std::vector< StrPtr_t > _threadNamesReceived;
+
+   // Callsites sent by the client, indexed by their callsite id
+   struct Callsite
+   {
+      StrPtr_t fileNameId;  // Indexes in the string database
+      StrPtr_t fctNameId;
+      LineNb_t lineNb;
+   };
+   std::vector< Callsite > _callsites;
 };
 
+// Serialization of a batch of pending data. The threads without any data are skipped
+size_t serializedSize( const Server::PendingData& pd );
+size_t serialize( const Server::PendingData& pd, char* dst );
+// Deserialize a batch into a cleared pending data
+size_t deserialize( const char* src, Server::PendingData& pd );
+
 }  // namespace hop
 
 #endif  // HOP_SERVER_H_
\ No newline at end of file
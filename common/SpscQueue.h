@@ -0,0 +1,58 @@
+#ifndef HOP_SPSC_QUEUE_H_
+#define HOP_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <stddef.h>
+
+namespace hop
+{
+// Bounded lock-free queue between a single producer thread and a single consumer
+// thread. The elements are exchanged with T::swap so that the storage of the
+// consumed elements goes back to the producer and can be reused.
+template <typename T, size_t N>
+class SpscQueue
+{
+   static_assert( N > 0 && ( N & ( N - 1 ) ) == 0, "SpscQueue capacity must be a power of 2" );
+
+  public:
+   // Producer side. Swap value with a free slot of the queue. Returns false if the
+   // queue is full, in which case value is left untouched.
+   bool push( T& value )
+   {
+      const size_t tail = _tail.load( std::memory_order_relaxed );
+      if( tail - _head.load( std::memory_order_acquire ) == N ) return false;
+
+      _slots[tail & ( N - 1 )].swap( value );
+      _tail.store( tail + 1, std::memory_order_release );
+      return true;
+   }
+
+   // Consumer side. Swap value with the oldest element of the queue. Returns false
+   // if the queue is empty, in which case value is left untouched.
+   bool pop( T& value )
+   {
+      const size_t head = _head.load( std::memory_order_relaxed );
+      if( head == _tail.load( std::memory_order_acquire ) ) return false;
+
+      _slots[head & ( N - 1 )].swap( value );
+      _head.store( head + 1, std::memory_order_release );
+      return true;
+   }
+
+   bool empty() const
+   {
+      return _head.load( std::memory_order_acquire ) == _tail.load( std::memory_order_acquire );
+   }
+
+  private:
+   T _slots[N];
+   // Keep the indexes on different cache lines so that the threads do not contend
+   // on them. Padding is used rather than alignas since the queue may be heap allocated.
+   std::atomic<size_t> _head{0};  // Only written by the consumer
+   char _padding[64 - sizeof( std::atomic<size_t> )];
+   std::atomic<size_t> _tail{0};  // Only written by the producer
+};
+
+}  // namespace hop
+
+#endif  // HOP_SPSC_QUEUE_H_
@@ -29,13 +29,15 @@ void printUsage( const char* progname )
        "Usage : %s [OPTION] <process name>\n\n OPTIONS:\n"
        "\t-o output path for saved file\n"
        "\t-e Launch specified executable with its arguments and start recording\n"
+       "\t-r Stream the recording to the output file as it is received\n"
+       "\t-m Save an uncompressed file that is mapped in memory when opened\n"
        "\t-v Display version info and exit\n\t-h Show usage\n",
        progname );
 }
 
 LaunchOptions parseArgs( int argc, char* argv[] )
 {
-   LaunchOptions lo{nullptr, nullptr, nullptr, nullptr, false};
+   LaunchOptions lo{nullptr, nullptr, nullptr, nullptr, false, false, false};
 
    // Invalid argument count
    if ( argc == 1 )
@@ -64,6 +66,12 @@ LaunchOptions parseArgs( int argc, char* argv[] )
                }
                lo.saveFilePath = argv[i];
                break;
+            case 'r':
+               lo.streamToFile = true;
+               break;
+            case 'm':
+               lo.mappableFile = true;
+               break;
             case 'e':
                if( !argv[++i] )
                {
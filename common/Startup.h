@@ -14,6 +14,8 @@ struct LaunchOptions
    const char* saveFilePath;
    char** args;
    bool startExec;
+   bool streamToFile;
+   bool mappableFile;
 };
 
 void printUsage( const char* progname );
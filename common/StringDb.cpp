@@ -1,7 +1,9 @@
 #include "StringDb.h"
 #include "common/Utils.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <cstring>
 
 static uint32_t alignOn( uint32_t val, uint32_t alignment )
@@ -9,10 +11,33 @@ static uint32_t alignOn( uint32_t val, uint32_t alignment )
    return (( val + alignment-1) & ~(alignment-1));
 }
 
+static constexpr uint32_t TRIGRAM_SIZE = 3;
+static constexpr uint32_t TRIGRAM_CHAR_BITS = 6;
+static constexpr uint32_t TRIGRAM_COUNT = 1 << ( TRIGRAM_SIZE * TRIGRAM_CHAR_BITS );
+
+// Case insensitive trigrams of the string, in order of appearance. Only the
+// low bits of the characters are kept, which leaves the letters, digits and most
+// symbols distinct. The few characters that collide are sorted out when the
+// candidates are verified.
+static void getTrigrams( const char* str, size_t length, std::vector<uint32_t>& trigrams )
+{
+   trigrams.clear();
+   for( size_t i = 0; i + TRIGRAM_SIZE <= length; ++i )
+   {
+      uint32_t trigram = 0;
+      for( size_t j = 0; j < TRIGRAM_SIZE; ++j )
+      {
+         const uint32_t c = std::toupper( (unsigned char)str[i + j] ) & ( ( 1 << TRIGRAM_CHAR_BITS ) - 1 );
+         trigram = ( trigram << TRIGRAM_CHAR_BITS ) | c;
+      }
+      trigrams.push_back( trigram );
+   }
+}
+
 namespace hop
 {
 
-StringDb::StringDb()
+StringDb::StringDb( bool searchable ) : _searchable( searchable )
 {
    _strData.reserve( 512 );
    _stringIndices.reserve( 256 );
@@ -28,12 +53,29 @@ void StringDb::clear()
 {
    _strData.clear();
    _stringIndices.clear();
+   _trigramIndex.clear();
+}
+
+void StringDb::indexString( size_t index, std::vector<uint32_t>& trigrams )
+{
+   if( _trigramIndex.empty() ) _trigramIndex.resize( TRIGRAM_COUNT );
+
+   // The strings are indexed in increasing order, so a trigram appearing several
+   // times in the string is already at the back of its list
+   const uint32_t strIdx = index / 8;
+   getTrigrams( &_strData[index], strlen( &_strData[index] ), trigrams );
+   for( uint32_t t : trigrams )
+   {
+      std::vector<uint32_t>& strings = _trigramIndex[t];
+      if( strings.empty() || strings.back() != strIdx ) strings.push_back( strIdx );
+   }
 }
 
 void StringDb::addStringData( const char* inData, size_t count )
 {
    using namespace hop;
    size_t i = 0;
+   std::vector<uint32_t> trigrams;
 
    while ( i < count )
    {
@@ -48,6 +90,7 @@ void StringDb::addStringData( const char* inData, size_t count )
          strIndex = _strData.size();
          _strData.resize( _strData.size() + stringLen );
          strcpy( &_strData[strIndex], &inData[i] );
+         if( _searchable ) indexString( strIndex, trigrams );
       }
 
       i += stringLen;
@@ -75,6 +118,56 @@ size_t StringDb::sizeInBytes() const
 }
 
 std::vector< size_t > StringDb::findStringIndexMatching( const char* substrToFind ) const noexcept
+{
+   const size_t subStrLen = strlen( substrToFind );
+   if( !_searchable || subStrLen < TRIGRAM_SIZE ) return findStringIndexMatchingNoIndex( substrToFind );
+
+   // Only the strings containing all the trigrams of the searched string can match.
+   // Start from the shortest list so the candidates get small quickly.
+   std::vector<uint32_t> trigrams;
+   getTrigrams( substrToFind, subStrLen, trigrams );
+   std::sort( trigrams.begin(), trigrams.end() );
+   trigrams.erase( std::unique( trigrams.begin(), trigrams.end() ), trigrams.end() );
+
+   std::vector<const std::vector<uint32_t>*> lists;
+   lists.reserve( trigrams.size() );
+   for( uint32_t t : trigrams )
+   {
+      if( _trigramIndex.empty() || _trigramIndex[t].empty() ) return std::vector<size_t>();
+      lists.push_back( &_trigramIndex[t] );
+   }
+   std::sort( lists.begin(), lists.end(), []( const std::vector<uint32_t>* lhs, const std::vector<uint32_t>* rhs ) {
+      return lhs->size() < rhs->size();
+   } );
+
+   std::vector<uint32_t> candidates( *lists[0] ), intersection;
+   for( size_t i = 1; i < lists.size() && !candidates.empty(); ++i )
+   {
+      intersection.clear();
+      std::set_intersection(
+          candidates.begin(),
+          candidates.end(),
+          lists[i]->begin(),
+          lists[i]->end(),
+          std::back_inserter( intersection ) );
+      std::swap( candidates, intersection );
+   }
+
+   // The trigrams can be found in any order in the candidates, so verify them
+   std::vector< size_t > indices;
+   indices.reserve( candidates.size() );
+   for( uint32_t c : candidates )
+   {
+      const size_t idx = (size_t)c * 8;
+      if( findSubstrNoCase( &_strData[idx], strlen( &_strData[idx] ), substrToFind, subStrLen ) != -1 )
+      {
+         indices.push_back( idx );
+      }
+   }
+   return indices;
+}
+
+std::vector< size_t > StringDb::findStringIndexMatchingNoIndex( const char* substrToFind ) const
 {
    std::vector< size_t > indices;
    indices.reserve( 64 );
@@ -160,6 +253,17 @@ size_t deserialize( const char* data, StringDb& strDb )
    const size_t dataStart = mapStart + entryCount * mapEntrySize;
    memcpy( strDb._strData.data(), &data[ dataStart ], dataSize );
 
+   // Rebuild the trigram index of the strings
+   strDb._trigramIndex.clear();
+   if( strDb._searchable )
+   {
+      std::vector<uint32_t> trigrams;
+      for( size_t i = 0; i < dataSize; i += alignOn( strlen( &strDb._strData[i] ) + 1, 8 ) )
+      {
+         strDb.indexString( i, trigrams );
+      }
+   }
+
    return 2 * sizeof( uint32_t ) + dataSize + entryCount * mapEntrySize;
 }
 
@@ -12,7 +12,9 @@ namespace hop
 class StringDb
 {
 public:
-   StringDb();
+   // The trigram index speeding up findStringIndexMatching is only built when
+   // searchable, as the databases only used to map the strings do not need it
+   explicit StringDb( bool searchable = false );
    bool empty() const;
    void clear();
    void addStringData( const std::vector<char>& inData );
@@ -30,8 +32,15 @@ public:
    friend size_t deserialize( const char* data, StringDb& strDb );
 
 private:
+   void indexString( size_t index, std::vector< uint32_t >& trigrams );
+   std::vector< size_t > findStringIndexMatchingNoIndex( const char* ) const;
+
    std::unordered_map< hop::StrPtr_t, size_t > _stringIndices;
    std::vector< char > _strData;
+   bool _searchable;
+   // For each case insensitive trigram, the strings containing it in increasing order.
+   // Since strings are aligned on 8 bytes, their index is stored divided by 8.
+   std::vector< std::vector< uint32_t > > _trigramIndex;
 };
 
 } // namespace hop
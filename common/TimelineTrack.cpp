@@ -17,6 +17,24 @@ static void addLockWaitsRecord( hop::LockWaitsRecords* records, size_t index )
    records->indices[records->count++] = index;
 }
 
+static void addToCallsiteTraces( hop::CallsiteTraces* callsiteTraces, const hop::TraceData& traces, size_t from )
+{
+   using namespace hop;
+   forEachSpan(
+       from,
+       traces.fctNameIds.size(),
+       [callsiteTraces]( size_t first, size_t count, const StrPtr_t* fileNames, const StrPtr_t* fctNames, const LineNb_t* lineNbs ) {
+          for( size_t i = 0; i < count; ++i )
+          {
+             const Callsite cs = {fileNames[i], fctNames[i], lineNbs[i]};
+             ( *callsiteTraces )[cs].push_back( first + i );
+          }
+       },
+       traces.fileNameIds,
+       traces.fctNameIds,
+       traces.lineNbs );
+}
+
 static void keepLatestLockWaitsRecords( hop::LockWaitsRecords* records, uint32_t countToKeep )
 {
    if( countToKeep < records->count )
@@ -39,25 +57,28 @@ StrPtr_t TimelineTrack::name() const noexcept
    return _trackName;
 }
 
-void TimelineTrack::addTraces( const TraceData& newTraces )
+void TimelineTrack::addTraces( TraceData&& newTraces )
 {
    HOP_ZONE( 1 );
    HOP_PROF_FUNC();
 
-   _traces.append( newTraces );
+   const size_t prevSize = _traces.fctNameIds.size();
+   _traces.append( std::move( newTraces ) );
 
    assert_is_sorted( _traces.entries.ends.begin(), _traces.entries.ends.end() );
+
+   addToCallsiteTraces( &_tracesPerCallsite, _traces, prevSize );
 }
 
-void TimelineTrack::addLockWaits( const LockWaitData& lockWaits )
+void TimelineTrack::addLockWaits( LockWaitData&& lockWaits )
 {
    HOP_PROF_FUNC();
    const size_t prevSize = _lockWaits.mutexAddrs.size();
-   _lockWaits.append( lockWaits );
+   _lockWaits.append( std::move( lockWaits ) );
 
-   for( size_t i = 0; i < lockWaits.mutexAddrs.size(); ++i )
+   for( size_t i = prevSize; i < _lockWaits.mutexAddrs.size(); ++i )
    {
-      addLockWaitsRecord( &_lockWaitsPerMutex[ lockWaits.mutexAddrs[i] ], prevSize + i );
+      addLockWaitsRecord( &_lockWaitsPerMutex[ _lockWaits.mutexAddrs[i] ], i );
    }
 }
 
@@ -93,10 +114,10 @@ void TimelineTrack::addUnlockEvents( const std::vector<UnlockEvent>& unlockEvent
    }
 }
 
-void TimelineTrack::addCoreEvents( const CoreEventData& coreEvents )
+void TimelineTrack::addCoreEvents( CoreEventData&& coreEvents )
 {
    HOP_PROF_FUNC();
-   _coreEvents.append( coreEvents );
+   _coreEvents.append( std::move( coreEvents ) );
 }
 
 Depth_t TimelineTrack::maxDepth() const noexcept
@@ -109,6 +130,14 @@ bool TimelineTrack::empty() const
    return _traces.entries.ends.empty();
 }
 
+const std::vector<size_t>& TimelineTrack::tracesOfCallsite( size_t traceIdx ) const
+{
+   const Callsite cs = {_traces.fileNameIds[traceIdx], _traces.fctNameIds[traceIdx], _traces.lineNbs[traceIdx]};
+   const auto it = _tracesPerCallsite.find( cs );
+   assert( it != _tracesPerCallsite.end() );
+   return it->second;
+}
+
 /**
  * Serialization functions
  */
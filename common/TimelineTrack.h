@@ -5,6 +5,7 @@
 #include "TraceData.h"
 
 #include <unordered_map>
+#include <vector>
 
 namespace hop
 {
@@ -16,16 +17,45 @@ struct LockWaitsRecords
    uint32_t count;
 };
 
+// Source location of a trace
+struct Callsite
+{
+   StrPtr_t fileName;
+   StrPtr_t fctName;
+   LineNb_t lineNb;
+
+   friend bool operator==( const Callsite& lhs, const Callsite& rhs ) noexcept
+   {
+      return lhs.fctName == rhs.fctName && lhs.fileName == rhs.fileName && lhs.lineNb == rhs.lineNb;
+   }
+};
+
+struct CallsiteHash
+{
+   size_t operator()( const Callsite& cs ) const noexcept
+   {
+      size_t h = std::hash<StrPtr_t>()( cs.fctName );
+      h = h * 31 + std::hash<StrPtr_t>()( cs.fileName );
+      return h * 31 + std::hash<LineNb_t>()( cs.lineNb );
+   }
+};
+
+// Indices of the traces coming from each callsite, in increasing order
+using CallsiteTraces = std::unordered_map< Callsite, std::vector<size_t>, CallsiteHash >;
+
 struct TimelineTrack
 {
    void setName( StrPtr_t name ) noexcept;
    StrPtr_t name() const noexcept;
-   void addTraces( const TraceData& traces );
-   void addLockWaits( const LockWaitData& lockWaits );
+   void addTraces( TraceData&& traces );
+   void addLockWaits( LockWaitData&& lockWaits );
    void addUnlockEvents(const std::vector<UnlockEvent>& unlockEvents);
-   void addCoreEvents( const CoreEventData& coreEvents );
+   void addCoreEvents( CoreEventData&& coreEvents );
    Depth_t maxDepth() const noexcept;
    bool empty() const;
+   // Returns the indices, in increasing order, of the traces with the same callsite
+   // as the given trace
+   const std::vector<size_t>& tracesOfCallsite( size_t traceIdx ) const;
 
    TraceData _traces;
    LockWaitData _lockWaits;
@@ -33,6 +63,7 @@ struct TimelineTrack
    StrPtr_t _trackName{0};
 
    std::unordered_map< void*, LockWaitsRecords > _lockWaitsPerMutex;
+   CallsiteTraces _tracesPerCallsite;  // Updated as traces are added
 };
 
 size_t serializedSize( const TimelineTrack& ti );
@@ -24,6 +24,15 @@ void Entries::append( const Entries& newEntries )
    maxDepth = std::max( maxDepth, newEntries.maxDepth );
 }
 
+void Entries::append( Entries&& newEntries )
+{
+   starts.append( std::move( newEntries.starts ) );
+   ends.append( std::move( newEntries.ends ) );
+   depths.append( std::move( newEntries.depths ) );
+
+   maxDepth = std::max( maxDepth, newEntries.maxDepth );
+}
+
 Entries Entries::copy() const
 {
    Entries copy;
@@ -43,6 +52,15 @@ void TraceData::append( const TraceData& newTraces )
    zones.append( newTraces.zones.begin(), newTraces.zones.end() );
 }
 
+void TraceData::append( TraceData&& newTraces )
+{
+   entries.append( std::move( newTraces.entries ) );
+   fileNameIds.append( std::move( newTraces.fileNameIds ) );
+   fctNameIds.append( std::move( newTraces.fctNameIds ) );
+   lineNbs.append( std::move( newTraces.lineNbs ) );
+   zones.append( std::move( newTraces.zones ) );
+}
+
 void TraceData::clear()
 {
    entries.clear();
@@ -84,6 +102,24 @@ void LockWaitData::append( const LockWaitData& newLockWaits )
    }
 }
 
+void LockWaitData::append( LockWaitData&& newLockWaits )
+{
+   const uint32_t newLockCount = newLockWaits.entries.ends.size();
+   entries.append( std::move( newLockWaits.entries ) );
+   mutexAddrs.append( std::move( newLockWaits.mutexAddrs ) );
+
+   if( newLockWaits.lockReleases.empty() )
+   {
+      // Append 0 for lock releases. They will be filled when the unlock event are received
+      lockReleases.append( newLockCount, 0 );
+   }
+   else
+   {
+      assert( newLockWaits.lockReleases.size() == newLockCount );
+      lockReleases.append( std::move( newLockWaits.lockReleases ) );
+   }
+}
+
 void LockWaitData::clear()
 {
    entries.clear();
@@ -98,15 +134,20 @@ void CoreEventData::append( const CoreEventData& newCoreEvents )
    cores.append( newCoreEvents.cores.begin(), newCoreEvents.cores.end() );
 }
 
+void CoreEventData::append( CoreEventData&& newCoreEvents )
+{
+   entries.append( std::move( newCoreEvents.entries ) );
+   cores.append( std::move( newCoreEvents.cores ) );
+}
+
 void CoreEventData::clear()
 {
    entries.clear();
    cores.clear();
 }
 
-static size_t serializedSize( const hop::Entries& entries )
+static size_t serializedSize( size_t entriesCount )
 {
-   const size_t entriesCount = entries.ends.size();
    const size_t size = sizeof( hop::Depth_t ) +                        // Max depth
                        sizeof( hop::TimeStamp ) * entriesCount +       // starts
                        sizeof( hop::TimeStamp ) * entriesCount +       // ends
@@ -114,12 +155,11 @@ static size_t serializedSize( const hop::Entries& entries )
    return size;
 }
 
-static size_t serialize( const hop::Entries& entries, char* dst )
+static size_t serialize( const hop::Entries& entries, size_t from, size_t to, char* dst )
 {
    size_t i = 0;
 
-   const size_t tracesCount = entries.ends.size();
-   (void)tracesCount;
+   const size_t tracesCount = to - from;
 
    // Max depth
    memcpy( &dst[i], &entries.maxDepth, sizeof( hop::Depth_t ) );
@@ -127,19 +167,19 @@ static size_t serialize( const hop::Entries& entries, char* dst )
 
    // ends
    {
-      std::copy( entries.ends.begin(), entries.ends.end(), (hop::TimeStamp*)&dst[i] );
+      std::copy( entries.ends.begin() + from, entries.ends.begin() + to, (hop::TimeStamp*)&dst[i] );
       i += sizeof( hop::TimeStamp ) * tracesCount;
    }
 
    // starts
    {
-      std::copy( entries.starts.begin(), entries.starts.end(), (hop::TimeStamp*)&dst[i] );
+      std::copy( entries.starts.begin() + from, entries.starts.begin() + to, (hop::TimeStamp*)&dst[i] );
       i += sizeof( hop::TimeStamp ) * tracesCount;
    }
 
    // depths
    {
-      std::copy( entries.depths.begin(), entries.depths.end(), (hop::Depth_t*)&dst[i] );
+      std::copy( entries.depths.begin() + from, entries.depths.begin() + to, (hop::Depth_t*)&dst[i] );
       i += sizeof( hop::Depth_t ) * tracesCount;
    }
 
@@ -173,10 +213,15 @@ static size_t deserialize( const char* src, size_t count, hop::Entries& entries
 
 size_t serializedSize( const TraceData& td )
 {
-   const size_t tracesCount = td.entries.ends.size();
+   return serializedSize( td, 0, td.entries.ends.size() );
+}
+
+size_t serializedSize( const TraceData& /*td*/, size_t from, size_t to )
+{
+   const size_t tracesCount = to - from;
    const size_t size =
        sizeof( size_t ) +                           // Traces count
-       serializedSize( td.entries ) +               // Entries size
+       serializedSize( tracesCount ) +              // Entries size
        sizeof( hop::StrPtr_t ) * tracesCount * 2 +  // fileNameId and fctNameIds
        sizeof( hop::LineNb_t ) * tracesCount +      // lineNbs
        sizeof( hop::ZoneId_t ) * tracesCount;       // zones
@@ -185,38 +230,43 @@ size_t serializedSize( const TraceData& td )
 }
 
 size_t serialize( const TraceData& td, char* dst )
+{
+   return serialize( td, 0, td.entries.ends.size(), dst );
+}
+
+size_t serialize( const TraceData& td, size_t from, size_t to, char* dst )
 {
    size_t i = 0;
 
    // Traces count
-   const size_t tracesCount = td.entries.ends.size();
+   const size_t tracesCount = to - from;
    memcpy( &dst[i], &tracesCount, sizeof( size_t ) );
    i += sizeof( size_t );
 
    // Entries
-   i += serialize( td.entries, &dst[i] );
+   i += serialize( td.entries, from, to, &dst[i] );
 
    // fileNameIds
    {
-      std::copy( td.fileNameIds.begin(), td.fileNameIds.end(), (hop::StrPtr_t*)&dst[i] );
+      std::copy( td.fileNameIds.begin() + from, td.fileNameIds.begin() + to, (hop::StrPtr_t*)&dst[i] );
       i += sizeof( hop::StrPtr_t ) * tracesCount;
    }
 
    // fctNameIds
    {
-      std::copy( td.fctNameIds.begin(), td.fctNameIds.end(), (hop::StrPtr_t*)&dst[i] );
+      std::copy( td.fctNameIds.begin() + from, td.fctNameIds.begin() + to, (hop::StrPtr_t*)&dst[i] );
       i += sizeof( hop::StrPtr_t ) * tracesCount;
    }
 
    // lineNbs
    {
-      std::copy( td.lineNbs.begin(), td.lineNbs.end(), (hop::LineNb_t*)&dst[i] );
+      std::copy( td.lineNbs.begin() + from, td.lineNbs.begin() + to, (hop::LineNb_t*)&dst[i] );
       i += sizeof( hop::LineNb_t ) * tracesCount;
    }
 
    // zones
    {
-      std::copy( td.zones.begin(), td.zones.end(), (hop::ZoneId_t*)&dst[i] );
+      std::copy( td.zones.begin() + from, td.zones.begin() + to, (hop::ZoneId_t*)&dst[i] );
       i += sizeof( hop::ZoneId_t ) * tracesCount;
    }
 
@@ -259,9 +309,14 @@ size_t deserialize( const char* src, TraceData& td )
 
 size_t serializedSize( const LockWaitData& lw )
 {
-   const size_t lockwaitsCount = lw.entries.ends.size();
+   return serializedSize( lw, 0, lw.entries.ends.size() );
+}
+
+size_t serializedSize( const LockWaitData& /*lw*/, size_t from, size_t to )
+{
+   const size_t lockwaitsCount = to - from;
    const size_t size = sizeof( size_t ) +                              // LockWaits count
-                       serializedSize( lw.entries ) +                  // Entries size
+                       serializedSize( lockwaitsCount ) +              // Entries size
                        sizeof( void* ) * lockwaitsCount +              // mutexAddrs
                        sizeof( hop::TimeStamp ) * lockwaitsCount;      // lockReleases
    return size;
@@ -269,7 +324,12 @@ size_t serializedSize( const LockWaitData& lw )
 
 size_t serialize( const LockWaitData& lw, char* dst )
 {
-   const size_t lockwaitsCount = lw.entries.ends.size();
+   return serialize( lw, 0, lw.entries.ends.size(), dst );
+}
+
+size_t serialize( const LockWaitData& lw, size_t from, size_t to, char* dst )
+{
+   const size_t lockwaitsCount = to - from;
 
    size_t i = 0;
 
@@ -277,14 +337,14 @@ size_t serialize( const LockWaitData& lw, char* dst )
    i += sizeof( size_t );
 
    // Entries
-   i += serialize( lw.entries, &dst[i] );
+   i += serialize( lw.entries, from, to, &dst[i] );
 
    // mutexAddrs
-   std::copy( lw.mutexAddrs.begin(), lw.mutexAddrs.end(), (void**)&dst[i] );
+   std::copy( lw.mutexAddrs.begin() + from, lw.mutexAddrs.begin() + to, (void**)&dst[i] );
    i += sizeof( void* ) * lockwaitsCount;
 
    // lockReleases
-   std::copy( lw.lockReleases.begin(), lw.lockReleases.end(), (hop::TimeStamp*)&dst[i] );
+   std::copy( lw.lockReleases.begin() + from, lw.lockReleases.begin() + to, (hop::TimeStamp*)&dst[i] );
    i += sizeof( hop::TimeStamp ) * lockwaitsCount;
 
    return i;
@@ -312,26 +372,36 @@ size_t deserialize( const char* src, LockWaitData& lw )
 }
 
 size_t serializedSize( const CoreEventData& ced )
+{
+   return serializedSize( ced, 0, ced.cores.size() );
+}
+
+size_t serializedSize( const CoreEventData& /*ced*/, size_t from, size_t to )
 {
    return sizeof( size_t ) +                              // CoreEvents count
-          serializedSize( ced.entries ) +                 // Entries
-          ced.cores.size() * sizeof( ced.cores[0] );      // Core information
+          serializedSize( to - from ) +                   // Entries
+          ( to - from ) * sizeof( Core_t );               // Core information
 }
 
 size_t serialize( const CoreEventData& ced, char* dst )
+{
+   return serialize( ced, 0, ced.cores.size(), dst );
+}
+
+size_t serialize( const CoreEventData& ced, size_t from, size_t to, char* dst )
 {
    size_t i = 0;
 
-   const size_t coreEventCount = ced.cores.size();
+   const size_t coreEventCount = to - from;
 
    memcpy( &dst[i], &coreEventCount, sizeof( size_t ) );
    i += sizeof( size_t );
 
    // Entries
-   i += serialize( ced.entries, &dst[i] );
+   i += serialize( ced.entries, from, to, &dst[i] );
 
    // Core Events
-   std::copy( ced.cores.begin(), ced.cores.end(), (Core_t*)&dst[i] );
+   std::copy( ced.cores.begin() + from, ced.cores.begin() + to, (Core_t*)&dst[i] );
    i += sizeof( ced.cores[0] ) * coreEventCount;
 
    return i;
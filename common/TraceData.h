@@ -19,6 +19,7 @@ struct Entries
 
    void clear();
    void append( const Entries& newEntries );
+   void append( Entries&& newEntries );
    Entries copy() const;
 
    Depth_t maxDepth{ 0 };
@@ -35,6 +36,8 @@ struct TraceData
    TraceData copy() const;
 
    void append( const TraceData& newTraces );
+   // Adopts the blocks of newTraces instead of copying them whenever possible
+   void append( TraceData&& newTraces );
    void clear();
 
    Entries entries;
@@ -55,6 +58,7 @@ struct LockWaitData
    LockWaitData& operator=(const LockWaitData& ) = delete;
 
    void append( const LockWaitData& newLockWaits );
+   void append( LockWaitData&& newLockWaits );
    void clear();
 
    Entries entries;
@@ -70,6 +74,7 @@ struct CoreEventData
    CoreEventData& operator=(const CoreEventData& ) = delete;
 
    void append( const CoreEventData& newCoreEvents );
+   void append( CoreEventData&& newCoreEvents );
    void clear();
 
    Entries entries;
@@ -86,6 +91,14 @@ size_t serialize( const CoreEventData& ced, char* dst );
 size_t deserialize( const char* src, TraceData& td );
 size_t deserialize( const char* src, LockWaitData& lw );
 size_t deserialize( const char* src, CoreEventData& ced );
+// Serialization of the [from, to) range of the entries. It is deserialized the same
+// way as the whole data.
+size_t serializedSize( const TraceData& td, size_t from, size_t to );
+size_t serializedSize( const LockWaitData& lw, size_t from, size_t to );
+size_t serializedSize( const CoreEventData& ced, size_t from, size_t to );
+size_t serialize( const TraceData& td, size_t from, size_t to, char* dst );
+size_t serialize( const LockWaitData& lw, size_t from, size_t to, char* dst );
+size_t serialize( const CoreEventData& ced, size_t from, size_t to, char* dst );
 
 }
 
@@ -2,7 +2,13 @@
 
 #include "common/platform/Platform.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace hop
 {
@@ -191,4 +197,133 @@ int pidStrToInt( const char* str )
    return pid;
 }
 
+// Threads kept alive for the whole run, so that parallelFor does not pay for creating
+// and joining them on every call. The calls are queued and the workers hand out the
+// indices of the oldest one first. The calling thread works on its own call as well,
+// so nested or concurrent calls always make progress.
+class ThreadPool
+{
+  public:
+   ThreadPool()
+   {
+      const unsigned workerCount = std::max( std::thread::hardware_concurrency(), 1u ) - 1;
+      for( unsigned i = 0; i < workerCount; ++i )
+      {
+         _workers.emplace_back( [this]() { workerLoop(); } );
+      }
+   }
+
+   ~ThreadPool()
+   {
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _stop = true;
+      }
+      _newJob.notify_all();
+      for( auto& t : _workers )
+      {
+         t.join();
+      }
+   }
+
+   void run( size_t count, const std::function<void( size_t )>& fct )
+   {
+      if( _workers.empty() || count <= 1 )
+      {
+         for( size_t i = 0; i < count; ++i ) fct( i );
+         return;
+      }
+
+      Job job{&fct, count, 0, 0};
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _jobs.push_back( &job );
+      }
+      _newJob.notify_all();
+
+      std::unique_lock<std::mutex> lock( _mutex );
+      size_t idx;
+      while( nextIndex( job, &idx ) )
+      {
+         lock.unlock();
+         fct( idx );
+         lock.lock();
+         ++job.doneCount;
+      }
+
+      // Wait for the indices still running on the workers
+      _jobDone.wait( lock, [&job]() { return job.doneCount == job.count; } );
+   }
+
+  private:
+   // A parallelFor call. It lives on the stack of the calling thread, and is only
+   // accessed with the mutex locked.
+   struct Job
+   {
+      const std::function<void( size_t )>* fct;
+      size_t count;
+      size_t nextIdx;
+      size_t doneCount;
+   };
+
+   // Take the next index of the job, and remove the job from the queue once all its
+   // indices were handed out. Must be called with the mutex locked.
+   bool nextIndex( Job& job, size_t* idx )
+   {
+      if( job.nextIdx == job.count ) return false;
+
+      *idx = job.nextIdx++;
+      if( job.nextIdx == job.count )
+      {
+         _jobs.erase( std::find( _jobs.begin(), _jobs.end(), &job ) );
+      }
+      return true;
+   }
+
+   void workerLoop()
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      while( true )
+      {
+         _newJob.wait( lock, [this]() { return _stop || !_jobs.empty(); } );
+         if( _jobs.empty() ) return;
+
+         Job& job = *_jobs.front();
+         size_t idx;
+         nextIndex( job, &idx );
+         lock.unlock();
+         ( *job.fct )( idx );
+         lock.lock();
+
+         // The job can be destroyed by its caller as soon as the mutex is released
+         if( ++job.doneCount == job.count ) _jobDone.notify_all();
+      }
+   }
+
+   std::vector<std::thread> _workers;
+   std::deque<Job*> _jobs;
+   std::mutex _mutex;
+   std::condition_variable _newJob;
+   std::condition_variable _jobDone;
+   bool _stop{false};
+};
+
+void parallelFor( size_t count, const std::function<void( size_t )>& fct )
+{
+   static ThreadPool pool;
+   pool.run( count, fct );
+}
+
+static std::atomic<void ( * )()> g_wakeUpCallback{nullptr};
+
+void setWakeUpCallback( void ( *callback )() )
+{
+   g_wakeUpCallback = callback;
+}
+
+void wakeUpMainLoop()
+{
+   if( auto callback = g_wakeUpCallback.load() ) callback();
+}
+
 } // namespace hop
\ No newline at end of file
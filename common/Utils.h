@@ -110,6 +110,16 @@ int findSubstrNoCase(
 
 int pidStrToInt( const char* str );
 
+// Call fct for every index in [0, count) using all the cores of the machine. The work
+// is dispatched to a pool of threads created on the first call. Returns once all the
+// calls are done.
+void parallelFor( size_t count, const std::function<void( size_t )>& fct );
+
+// Wake up the main loop of the viewer while it waits for events, so the data produced
+// by a background thread gets displayed. Does nothing until a callback is set.
+void setWakeUpCallback( void ( *callback )() );
+void wakeUpMainLoop();
+
 template< typename IT >
 void insertionSort( IT begin, IT end )
 {
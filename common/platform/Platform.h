@@ -32,6 +32,10 @@ void setupSignalHandlers( void (*terminateCB)(int) );
 void* virtualAlloc( uint64_t size );
 void virtualFree( void* memory, uint64_t size );
 
+// Map the whole file in memory. Written pages are copied and never reach the file.
+void* mapFile( const char* path, uint64_t* size );
+void unmapFile( void* memory, uint64_t size );
+
 uint32_t getTempFolderPath( char* buffer, uint32_t size );
 uint32_t getWorkingDirectory( char* buffer, uint32_t size );
 
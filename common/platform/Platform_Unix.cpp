@@ -1,11 +1,13 @@
 #include "Platform.h"
 
+#include <fcntl.h>
 #include <inttypes.h>
 #include <signal.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -171,6 +173,33 @@ void virtualFree( void* memory, uint64_t size )
    munmap( memory, size );
 }
 
+void* mapFile( const char* path, uint64_t* size )
+{
+   const int fd = open( path, O_RDONLY );
+   if( fd < 0 ) return nullptr;
+
+   struct stat st;
+   void* mem = nullptr;
+   if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+   {
+      mem = mmap( nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+      if( mem == (void*)-1 )
+      {
+         mem = nullptr;
+      }
+      *size = st.st_size;
+   }
+
+   // The mapping keeps its own reference to the file
+   close( fd );
+   return mem;
+}
+
+void unmapFile( void* memory, uint64_t size )
+{
+   munmap( memory, size );
+}
+
 uint32_t getTempFolderPath( char* buffer, uint32_t size )
 {
    const char unixTempFolder[] = "/tmp/";
@@ -116,6 +116,35 @@ void virtualFree( void* memory, uint64_t size )
    VirtualFree( memory, size, MEM_RELEASE );
 }
 
+void* mapFile( const char* path, uint64_t* size )
+{
+   HANDLE file = CreateFileA(
+       path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+   if( file == INVALID_HANDLE_VALUE ) return nullptr;
+
+   void* mem = nullptr;
+   LARGE_INTEGER fileSize;
+   if( GetFileSizeEx( file, &fileSize ) && fileSize.QuadPart > 0 )
+   {
+      HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+      if( mapping )
+      {
+         mem = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+         CloseHandle( mapping );
+      }
+      *size = fileSize.QuadPart;
+   }
+
+   // The view keeps its own reference to the file
+   CloseHandle( file );
+   return mem;
+}
+
+void unmapFile( void* memory, uint64_t )
+{
+   UnmapViewOfFile( memory );
+}
+
 uint32_t getTempFolderPath( char* buffer, uint32_t size )
 {
    return GetTempPathA( size, buffer );
@@ -0,0 +1,124 @@
+#include "hop/ActivityHistogram.h"
+
+#include "common/TraceData.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hop
+{
+
+// Merge the buckets two by two
+static void halveResolution( ActivityHistogram& hist )
+{
+   // The origin must stay aligned on the duration of the merged buckets
+   if( ( hist.origin >> hist.bucketShift ) & 1 )
+   {
+      hist.busy.insert( hist.busy.begin(), 0 );
+      hist.origin -= TimeStamp( 1 ) << hist.bucketShift;
+   }
+
+   const size_t count = ( hist.busy.size() + 1 ) / 2;
+   for( size_t i = 0; i < count; ++i )
+   {
+      const TimeDuration next = 2 * i + 1 < hist.busy.size() ? hist.busy[2 * i + 1] : 0;
+      hist.busy[i]            = hist.busy[2 * i] + next;
+   }
+   hist.busy.resize( count );
+   ++hist.bucketShift;
+}
+
+static void addBusyTime( ActivityHistogram& hist, TimeStamp start, TimeStamp end )
+{
+   if( end <= start ) return;
+
+   if( hist.busy.empty() )
+      hist.origin = ( start >> hist.bucketShift ) << hist.bucketShift;
+
+   // Lower the resolution until the buckets cover both the histogram and the entry
+   TimeStamp firstBucket, lastBucket;
+   while( true )
+   {
+      const TimeStamp originBucket = hist.origin >> hist.bucketShift;
+      firstBucket = std::min( originBucket, start >> hist.bucketShift );
+      lastBucket  = std::max(
+          originBucket + std::max< size_t >( hist.busy.size(), 1 ) - 1, ( end - 1 ) >> hist.bucketShift );
+      if( lastBucket - firstBucket < ACTIVITY_MAX_BUCKET_COUNT ) break;
+      halveResolution( hist );
+   }
+
+   const TimeStamp originBucket = hist.origin >> hist.bucketShift;
+   if( firstBucket < originBucket )
+   {
+      hist.busy.insert( hist.busy.begin(), originBucket - firstBucket, 0 );
+      hist.origin = firstBucket << hist.bucketShift;
+   }
+   hist.busy.resize( std::max< size_t >( hist.busy.size(), lastBucket - firstBucket + 1 ) );
+
+   // Then add the part of the entry in each bucket it overlaps
+   const TimeStamp histFirstBucket = hist.origin >> hist.bucketShift;
+   const TimeStamp bucketCycles    = TimeStamp( 1 ) << hist.bucketShift;
+   for( TimeStamp b = start >> hist.bucketShift; b <= ( end - 1 ) >> hist.bucketShift; ++b )
+   {
+      const TimeStamp bucketStart = b << hist.bucketShift;
+      const TimeStamp overlapStart = std::max( start, bucketStart );
+      const TimeStamp overlapEnd   = std::min( end, bucketStart + bucketCycles );
+      hist.busy[b - histFirstBucket] += overlapEnd - overlapStart;
+   }
+}
+
+void appendActivity( ActivityHistogram& hist, const Entries& entries )
+{
+   // Only the depth 0 entries are added, as the deeper ones are within them and the
+   // entries of a depth never overlap
+   const size_t count = entries.ends.size();
+   auto startIt = entries.starts.begin() + hist.entryCount;
+   auto endIt   = entries.ends.begin() + hist.entryCount;
+   auto depthIt = entries.depths.begin() + hist.entryCount;
+   for( size_t i = hist.entryCount; i < count; ++i, ++startIt, ++endIt, ++depthIt )
+   {
+      if( *depthIt == 0 ) addBusyTime( hist, *startIt, *endIt );
+   }
+   hist.entryCount = count;
+}
+
+void activityPerPixel(
+    const ActivityHistogram& hist,
+    TimeStamp start,
+    TimeDuration duration,
+    std::vector< float >& activity )
+{
+   std::fill( activity.begin(), activity.end(), 0.0f );
+   const int64_t pxlCount = activity.size();
+   if( hist.busy.empty() || duration <= 0 || pxlCount == 0 ) return;
+
+   const double pxlCycles    = (double)duration / pxlCount;
+   const double bucketCycles = (double)( TimeStamp( 1 ) << hist.bucketShift );
+   for( size_t b = 0; b < hist.busy.size(); ++b )
+   {
+      if( hist.busy[b] == 0 ) continue;
+
+      // Spread the busy time of the bucket evenly on the pixels it overlaps
+      const TimeStamp bucketTime = hist.origin + ( TimeStamp( b ) << hist.bucketShift );
+      const double bucketStart   = (double)(int64_t)( bucketTime - start );
+      const double bucketEnd     = bucketStart + bucketCycles;
+      if( bucketEnd <= 0.0 || bucketStart >= duration ) continue;
+
+      const double density = hist.busy[b] / bucketCycles;
+      const int64_t firstPxl = std::max< int64_t >( 0, (int64_t)std::floor( bucketStart / pxlCycles ) );
+      const int64_t lastPxl  = std::min< int64_t >( pxlCount - 1, (int64_t)std::floor( bucketEnd / pxlCycles ) );
+      for( int64_t p = firstPxl; p <= lastPxl; ++p )
+      {
+         const double overlap =
+             std::min( bucketEnd, ( p + 1 ) * pxlCycles ) - std::max( bucketStart, p * pxlCycles );
+         if( overlap > 0.0 ) activity[p] += density * overlap / pxlCycles;
+      }
+   }
+
+   for( float& a : activity )
+   {
+      a = std::min( a, 1.0f );
+   }
+}
+
+}  // namespace hop
@@ -0,0 +1,40 @@
+#ifndef ACTIVITY_HISTOGRAM_H_
+#define ACTIVITY_HISTOGRAM_H_
+
+#include "Hop.h"
+
+#include <vector>
+
+namespace hop
+{
+
+struct Entries;
+
+constexpr uint32_t ACTIVITY_MIN_BUCKET_SHIFT = 10;
+constexpr size_t ACTIVITY_MAX_BUCKET_COUNT   = 4096;
+
+// Busy time of a track in buckets of fixed duration covering the whole capture. When
+// the capture does not fit in the buckets anymore, they are merged two by two so the
+// resolution is halved and the size stays bounded.
+struct ActivityHistogram
+{
+   TimeStamp origin{0};  // Start of the first bucket, aligned on the bucket duration
+   uint32_t bucketShift{ACTIVITY_MIN_BUCKET_SHIFT};  // Buckets last 2^bucketShift cycles
+   std::vector< TimeDuration > busy;
+   size_t entryCount{0};  // Number of entries already added
+};
+
+// Add the busy time of the depth 0 entries following the ones already added
+void appendActivity( ActivityHistogram& hist, const Entries& entries );
+
+// Fill each value of the array with the fraction of time the track was busy in its
+// part of the range. Each value is in [0, 1].
+void activityPerPixel(
+    const ActivityHistogram& hist,
+    TimeStamp start,
+    TimeDuration duration,
+    std::vector< float >& activity );
+
+}
+
+#endif  // ACTIVITY_HISTOGRAM_H_
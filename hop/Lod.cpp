@@ -27,267 +27,218 @@ static inline hop::TimeDuration delta( const hop::LodInfo& lod )
    return lod.end - lod.start;
 }
 
-namespace hop
+enum PendingState : uint8_t
 {
-TimeDuration LOD_CYCLES[9] = {1000, 200000, 30000000, 300000000, 600000000, 6000000000, 20000000000, 200000000000, 600000000000 };
+   PENDING_OPEN,   // Can still be merged with the next LOD at the same depth
+   PENDING_FINAL,  // Waiting for the previous pending LODs to be final
+   PENDING_MOVED,  // Was merged into a LOD further in the queue
+};
 
-void setupLODResolution( uint32_t sreenResolutionX )
+static void addLod( hop::LodsData& data, int lodLvl, const hop::LodInfo& lod );
+
+// Move the pending LODs that cannot change anymore to their level and feed them to
+// the next level. If flush is true, all the pending LODs are considered final.
+static void emitFinalLods( hop::LodsData& data, int lodLvl, bool flush )
 {
-   for ( uint32_t i = 1; i < LOD_COUNT; ++i )
+   hop::LodBuilder& builder = data.builders[lodLvl];
+   while( !builder.pending.empty() )
    {
-      LOD_MIN_TRACE_LENGTH_CYCLES[i] =
-          pxlToCycles( sreenResolutionX, LOD_CYCLES[i-1], MIN_TRACE_LENGTH_PXL );
-      LOD_MIN_GAP_CYCLES[i] = pxlToCycles( sreenResolutionX, LOD_CYCLES[i-1], MIN_GAP_PXL );
+      hop::LodBuilder::Pending& front = builder.pending.front();
+      if( front.state == PENDING_OPEN )
+      {
+         // The next LODs end after the last one added. If it is too far, none of them
+         // can be merged with this one anymore.
+         const hop::TimeStamp mergeLimit =
+             front.info.end + LOD_MIN_GAP_CYCLES[lodLvl] + LOD_MIN_TRACE_LENGTH_CYCLES[lodLvl];
+         if( !flush && builder.lastEnd < mergeLimit ) break;
+
+         builder.openAtDepth[front.info.depth] = -1;
+         front.state = PENDING_FINAL;
+      }
+
+      if( front.state == PENDING_FINAL )
+      {
+         data.lods[lodLvl].push_back( front.info );
+         if( lodLvl + 1 < hop::LOD_COUNT ) addLod( data, lodLvl + 1, front.info );
+      }
+
+      builder.pending.pop_front();
+      ++builder.firstPendingPos;
    }
 }
 
-LodsArray computeLods( const Entries& entries, size_t idOffset )
-{
-   HOP_ZONE( 2 );
-   HOP_PROF_FUNC();
-   assert( LOD_MIN_GAP_CYCLES[LOD_COUNT - 1] > 0 && "LOD resolution was not setup" );
+// Core events are merged with the previous event of their level if they ran on the
+// same core. The pending queue of their builder only holds that previous event.
+static void addCoreEventLod( hop::LodsData& data, int lodLvl, const hop::LodInfo& lod, hop::Core_t core );
 
-   LodsArray resLods;
+static void emitCoreEventLod( hop::LodsData& data, int lodLvl )
+{
+   hop::LodBuilder& builder = data.builders[lodLvl];
+   const hop::LodInfo lod   = builder.pending.front().info;
+   builder.pending.pop_front();
 
-   std::vector<ssize_t> lastTraceAtDepth( entries.maxDepth + 1, -1 );
-   int lodLvl = 0;
+   data.lods[lodLvl].push_back( lod );
+   if( lodLvl + 1 < hop::LOD_COUNT ) addCoreEventLod( data, lodLvl + 1, lod, builder.pendingCore );
+}
 
-   // First LOD is usually never worth merging as they are too small
+static void addCoreEventLod( hop::LodsData& data, int lodLvl, const hop::LodInfo& lod, hop::Core_t core )
+{
+   hop::LodBuilder& builder = data.builders[lodLvl];
+   if( !builder.pending.empty() )
    {
-      HOP_PROF( "Copying first LOD level" );
-      for( size_t i = idOffset; i < entries.ends.size(); ++i )
+      hop::LodInfo& lastEvent = builder.pending.front().info;
+      const hop::TimeDuration timeBetweenEvents = lod.start - lastEvent.end;
+      if( builder.pendingCore == core && timeBetweenEvents < LOD_MIN_GAP_CYCLES[lodLvl] )
       {
-         resLods[0].push_back(
-             LodInfo{entries.starts[i], entries.ends[i], i, entries.depths[i], false} );
+         lastEvent.end   = lod.end;
+         lastEvent.loded = true;
+         return;
       }
+      emitCoreEventLod( data, lodLvl );
    }
 
-   // Compute the LOD based on the previous LOD levels
-   const hop::Deque<LodInfo>* lastComputedLod = &resLods[lodLvl];
-   for ( lodLvl = 1; lodLvl < LOD_COUNT; ++lodLvl )
-   {
-      HOP_PROF( "Computing next LOD lvl" );
-
-      std::fill( lastTraceAtDepth.begin(), lastTraceAtDepth.end(), -1 );
-      
-      for ( const auto& l : *lastComputedLod )
-      {
-         ssize_t lodedTraceIdx = -1;
-         const Depth_t depth = l.depth;
-         if( lastTraceAtDepth[depth] >= 0 )
-         {
-            const ssize_t lastTraceAtDepthIndex = lastTraceAtDepth[depth];
-            auto& lastTrace = resLods[lodLvl][lastTraceAtDepthIndex];
-            const TimeDuration timeBetweenTrace = l.start - lastTrace.end;
-            if( canBeLoded( lodLvl, timeBetweenTrace, delta( lastTrace ), delta(l) ) )
-            {
-               assert( lastTrace.depth == depth );
-               lodedTraceIdx = lastTraceAtDepthIndex;
-
-               // Update idx since we are about the remove a trace from the list
-               for( auto& idx : lastTraceAtDepth )
-               {
-                  if( idx > lastTraceAtDepthIndex )
-                     --idx;
-               }
-
-               const TimeStamp newStartTime = lastTrace.start;  // Keep around as it will be
-               resLods[lodLvl].erase(
-                   resLods[lodLvl].begin() + lastTraceAtDepthIndex,
-                   resLods[lodLvl].begin() + lastTraceAtDepthIndex + 1 );
-
-               // New last trace at depth is the next insertion that was merged with
-               // the previous last trace
-               assert( newStartTime < l.end );
-               lastTraceAtDepth[depth] = resLods[lodLvl].size();
-               resLods[lodLvl].push_back( LodInfo{newStartTime, l.end, l.index, depth, true} );
-            }
-         }
-
-         // If it was not loded, insert it and keep index
-         if( lodedTraceIdx == -1 )
-         {
-            // Save idx of the last entry at specific depth
-            lastTraceAtDepth[depth] = resLods[lodLvl].size();
-            resLods[lodLvl].push_back( LodInfo{l.start, l.end, l.index, l.depth, false} );
-         }
-      }
-
-      assert_is_sorted( resLods[lodLvl].begin(), resLods[lodLvl].end() );
+   builder.pending.push_back( hop::LodBuilder::Pending{lod, PENDING_OPEN} );
+   builder.pendingCore = core;
+}
 
-      // Update the last compute lod ptr
-      lastComputedLod = &resLods[lodLvl];
+static void removeProvisionalLods( hop::LodsData& data )
+{
+   for( int lodLvl = 0; lodLvl < hop::LOD_COUNT; ++lodLvl )
+   {
+      data.lods[lodLvl].pop_back( data.provisionalCount[lodLvl] );
+      data.provisionalCount[lodLvl] = 0;
    }
-
-   return resLods;
 }
 
-void appendLods( LodsData& dst, const Entries& entries )
+// Add the pending LODs to the levels so they are displayed, then restore the builders
+// as they were, so the pending LODs can still be merged on the next append
+template <typename FLUSH_FCT>
+static void addProvisionalLods( hop::LodsData& data, const FLUSH_FCT& flushLevel )
 {
-   if( entries.ends.size() <= dst.idOffset ) return;
-
-   LodsArray src = computeLods( entries, dst.idOffset );
-
-   HOP_PROF_FUNC();
-
-   // Find the deepest depth
-   int deepestDepth = 0;
-   for ( auto it = src[LOD_COUNT - 1].begin(); it != src[LOD_COUNT - 1].end(); ++it )
+   const auto builders = data.builders;
+   for( int lodLvl = 0; lodLvl < hop::LOD_COUNT; ++lodLvl )
    {
-      deepestDepth = std::max( deepestDepth, (int)it->depth );
+      data.provisionalCount[lodLvl] = data.lods[lodLvl].size();
    }
-
-   // For all LOD levels
-   for ( size_t i = 0; i < src.size(); ++i )
+   for( int lodLvl = 0; lodLvl < hop::LOD_COUNT; ++lodLvl )
    {
-      // First trace to insert
-      auto newTraceIt = src[i].cbegin();
-
-      // If there is already LOD in the dest, try to merge them
-      if ( dst.lods[i].size() > 0 )
-      {
-         // For each depth, we go through existing traces (dst) and see if
-         // we can merge it with the new trace.
-         int depthRemaining = deepestDepth;
-         while ( depthRemaining >= 0 && newTraceIt != src[i].cend() )
-         {
-            if ( newTraceIt->depth == depthRemaining )
-            {
-               // Reverse search to find the last trace that has the same depth as the processed one
-               auto sameDepthIt = dst.lods[i].end() -1;
-               while( sameDepthIt > dst.lods[i].begin() && sameDepthIt->depth != depthRemaining )
-               {
-                  --sameDepthIt;
-               }
-
-               if ( sameDepthIt != dst.lods[i].begin() )
-               {
-                  const auto timeBetweenTrace = newTraceIt->start - sameDepthIt->end;
-                  if ( canBeLoded( i, timeBetweenTrace, delta(*sameDepthIt), delta(*newTraceIt) ) )
-                  {
-                     newTraceIt->start = sameDepthIt->start;
-                     newTraceIt->loded = true;
-                     dst.lods[i].erase( sameDepthIt );
-                  }
-               }
-
-               --depthRemaining;
-            }
-
-            // Continue inserting
-            ++newTraceIt;
-         }
-      }
-
-      dst.lods[i].append( src[i].cbegin(), src[i].cend() );
+      flushLevel( data, lodLvl );
    }
-
-   // Update to the new offset
-   dst.idOffset = entries.ends.size();
+   for( int lodLvl = 0; lodLvl < hop::LOD_COUNT; ++lodLvl )
+   {
+      data.provisionalCount[lodLvl] = data.lods[lodLvl].size() - data.provisionalCount[lodLvl];
+   }
+   data.builders = builders;
 }
 
-LodsArray
-computeCoreEventLods( const Entries& entries, const hop::Deque<Core_t>& cores, size_t idOffset )
+// Add a LOD of the previous level, which must come in order of their end time
+static void addLod( hop::LodsData& data, int lodLvl, const hop::LodInfo& lod )
 {
-   HOP_PROF_FUNC();
-
-   LodsArray resLods;
+   hop::LodBuilder& builder = data.builders[lodLvl];
+   if( builder.openAtDepth.size() <= lod.depth ) builder.openAtDepth.resize( lod.depth + 1, -1 );
 
-   const auto mergeLodInfo = [&cores]( int lodLvl, LodInfo& lastEvent, const LodInfo& newEvent, LodsArray& resLods )
+   hop::LodInfo newLod = {lod.start, lod.end, lod.index, lod.depth, false};
+   const int64_t openPos = builder.openAtDepth[lod.depth];
+   if( openPos >= 0 )
    {
-      const int64_t timeBetweenTrace = newEvent.start - lastEvent.end;
-      if( cores[lastEvent.index] == cores[newEvent.index] &&
-            timeBetweenTrace < LOD_MIN_GAP_CYCLES[lodLvl] )
+      hop::LodBuilder::Pending& last = builder.pending[openPos - builder.firstPendingPos];
+      const hop::TimeDuration timeBetweenTrace = lod.start - last.info.end;
+      if( canBeLoded( lodLvl, timeBetweenTrace, delta( last.info ), delta( lod ) ) )
       {
-         lastEvent.end   = newEvent.end;
-         lastEvent.loded = true;
+         // The merged LOD now ends with the new one, so it moves to the back
+         assert( last.info.start < lod.end );
+         newLod.start = last.info.start;
+         newLod.loded = true;
+         last.state   = PENDING_MOVED;
       }
       else
       {
-         resLods[lodLvl].push_back( newEvent );
-      }
-   };
-
-   int lodLvl = 0;
-   // Compute first LOD from raw data
-   {
-      // First lod is always added
-      resLods[lodLvl].push_back(
-          LodInfo{entries.starts[idOffset], entries.ends[idOffset], idOffset, 0, false} );
-      HOP_PROF( "Compute first LOD level" );
-      for ( size_t i = idOffset + 1; i < entries.ends.size(); ++i )
-      {
-         mergeLodInfo(
-            lodLvl,
-            resLods[lodLvl].back(),
-            LodInfo{entries.starts[i], entries.ends[i], i, 0, false},
-            resLods );
+         last.state = PENDING_FINAL;
       }
-      std::sort( resLods[lodLvl].begin(), resLods[lodLvl].end() );
    }
 
-   // Compute the LOD based on the previous LOD levels
-   const hop::Deque<LodInfo>* lastComputedLod = &resLods[lodLvl];
-   for ( lodLvl = 1; lodLvl < LOD_COUNT; ++lodLvl )
-   {
-      HOP_PROF( "Computing next LOD lvl" );
-      resLods[lodLvl].push_back( lastComputedLod->front() );
-      for ( const auto& l : *lastComputedLod )
-      {
-         mergeLodInfo( lodLvl, resLods[lodLvl].back(), l, resLods );
-      }
-      std::sort( resLods[lodLvl].begin(), resLods[lodLvl].end() );
-
-      // Update the last compute lod ptr
-      lastComputedLod = &resLods[lodLvl];
-   }
+   // A LOD that is too long will not be merged with the next one
+   const bool mergeable = delta( newLod ) < LOD_MIN_TRACE_LENGTH_CYCLES[lodLvl];
+   builder.openAtDepth[lod.depth] = mergeable ? builder.firstPendingPos + builder.pending.size() : -1;
+   builder.pending.push_back( hop::LodBuilder::Pending{newLod, mergeable ? PENDING_OPEN : PENDING_FINAL} );
+   builder.lastEnd = lod.end;
 
-   return resLods;
+   emitFinalLods( data, lodLvl, false );
 }
 
-void appendCoreEventLods( LodsData& dst, const Entries& entries, const hop::Deque<Core_t>& cores )
+namespace hop
+{
+TimeDuration LOD_CYCLES[9] = {1000, 200000, 30000000, 300000000, 600000000, 6000000000, 20000000000, 200000000000, 600000000000 };
+
+void setupLODResolution( uint32_t sreenResolutionX )
 {
-   if( entries.ends.size() <= dst.idOffset ) return;
+   for ( uint32_t i = 1; i < LOD_COUNT; ++i )
+   {
+      LOD_MIN_TRACE_LENGTH_CYCLES[i] =
+          pxlToCycles( sreenResolutionX, LOD_CYCLES[i-1], MIN_TRACE_LENGTH_PXL );
+      LOD_MIN_GAP_CYCLES[i] = pxlToCycles( sreenResolutionX, LOD_CYCLES[i-1], MIN_GAP_PXL );
+   }
+}
 
-   LodsArray src = computeCoreEventLods( entries, cores, dst.idOffset );
+void appendLods( LodsData& dst, const Entries& newEntries )
+{
+   if( newEntries.ends.empty() ) return;
 
+   HOP_ZONE( 2 );
    HOP_PROF_FUNC();
+   assert( LOD_MIN_GAP_CYCLES[LOD_COUNT - 1] > 0 && "LOD resolution was not setup" );
 
-   // For all LOD levels
-   for( size_t lodLvl = 0; lodLvl < src.size(); ++lodLvl )
-   {
-      // First trace to insert
-      const auto& newEvent  = src[lodLvl].front();
-      long sortFromIdx      = dst.lods[lodLvl].size();
+   removeProvisionalLods( dst );
 
-      // If there is already LOD in the dest, try to merge them
-      bool loded = false;
-      if( !dst.lods[lodLvl].empty() )
-      {
-         auto& prevEvent                = dst.lods[lodLvl].back();
-         const int64_t timeBetweenTrace = newEvent.start - prevEvent.end;
-         if( cores[prevEvent.index] == cores[newEvent.index] &&
-             timeBetweenTrace < LOD_MIN_GAP_CYCLES[lodLvl] )
-         {
-            prevEvent.end   = newEvent.end;
-            prevEvent.loded = loded = true;
-         }
-      }
+   // First LOD is usually never worth merging as they are too small
+   forEachSpan(
+       0,
+       newEntries.ends.size(),
+       [&dst]( size_t first, size_t count, const TimeStamp* starts, const TimeStamp* ends, const Depth_t* depths ) {
+          for( size_t i = 0; i < count; ++i )
+          {
+             const LodInfo lod = {starts[i], ends[i], dst.idOffset + first + i, depths[i], false};
+             dst.lods[0].push_back( lod );
+             addLod( dst, 1, lod );
+          }
+       },
+       newEntries.starts,
+       newEntries.ends,
+       newEntries.depths );
+
+   addProvisionalLods( dst, []( LodsData& data, int lodLvl ) {
+      if( lodLvl > 0 ) emitFinalLods( data, lodLvl, true );
+   } );
+
+   dst.idOffset += newEntries.ends.size();
+}
 
-      // Insert all the events except the first one if it has been loded
-      dst.lods[lodLvl].append( src[lodLvl].cbegin() + (int)loded, src[lodLvl].cend() );
-      if( loded )
-      {
-         std::sort(
-             dst.lods[lodLvl].begin() + std::max( 0l, ( sortFromIdx - 1 ) ),
-             dst.lods[lodLvl].end() );
-      }
+void appendCoreEventLods( LodsData& dst, const Entries& newEntries, const hop::Deque<Core_t>& newCores )
+{
+   if( newEntries.ends.empty() ) return;
 
-      assert_is_sorted( dst.lods[lodLvl].begin(), dst.lods[lodLvl].end() );
-   }
+   HOP_PROF_FUNC();
 
-   // Update to the new offset
-   dst.idOffset = entries.ends.size();
+   removeProvisionalLods( dst );
+
+   forEachSpan(
+       0,
+       newEntries.ends.size(),
+       [&dst]( size_t first, size_t count, const TimeStamp* starts, const TimeStamp* ends, const Core_t* cores ) {
+          for( size_t i = 0; i < count; ++i )
+          {
+             addCoreEventLod( dst, 0, LodInfo{starts[i], ends[i], dst.idOffset + first + i, 0, false}, cores[i] );
+          }
+       },
+       newEntries.starts,
+       newEntries.ends,
+       newCores );
+
+   addProvisionalLods( dst, []( LodsData& data, int lodLvl ) {
+      if( !data.builders[lodLvl].pending.empty() ) emitCoreEventLod( data, lodLvl );
+   } );
+
+   dst.idOffset += newEntries.ends.size();
 }
 
 std::pair<size_t, size_t> visibleIndexSpan(
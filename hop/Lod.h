@@ -5,6 +5,7 @@
 #include "common/Deque.h"
 
 #include <array>
+#include <deque>
 #include <vector>
 
 namespace hop
@@ -26,21 +27,42 @@ struct LodInfo
 };
 
 using LodsArray = std::array< hop::Deque< LodInfo >, LOD_COUNT >;
+
+// LODs of a level that are not final yet, in the order they will be added to the
+// level. Only the last LOD of each depth can still be merged with the next ones.
+struct LodBuilder
+{
+   struct Pending
+   {
+      LodInfo info;
+      uint8_t state;
+   };
+   std::deque< Pending > pending;
+   uint64_t firstPendingPos{0};
+   std::vector< int64_t > openAtDepth;  // Position of the mergeable LOD, or -1
+   TimeStamp lastEnd{0};
+   Core_t pendingCore{0};  // Core of the pending event, for the core events LODs
+};
+
 struct LodsData
 {
    LodsArray lods;
-   size_t idOffset{0};
+   std::array< LodBuilder, LOD_COUNT > builders;
+   // Number of LODs at the end of each level that were added from the pending ones,
+   // so the latest traces are displayed. They are removed on the next append.
+   std::array< size_t, LOD_COUNT > provisionalCount{};
+   size_t idOffset{0};  // Number of entries already added
 };
 
 void setupLODResolution( uint32_t sreenResolutionX );
 
-// Create and appends lods
-void appendLods( LodsData& lodData, const Entries& entries );
+// Create and appends the lods of the entries following the ones already added
+void appendLods( LodsData& lodData, const Entries& newEntries );
 
 void appendCoreEventLods(
     LodsData& lodData,
-    const Entries& entries,
-    const hop::Deque<Core_t>& cores );
+    const Entries& newEntries,
+    const hop::Deque<Core_t>& newCores );
 
 std::pair<size_t, size_t> visibleIndexSpan(
     const LodsArray& lodsArr,
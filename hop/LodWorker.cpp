@@ -0,0 +1,195 @@
+#include "hop/LodWorker.h"
+
+#include "common/Utils.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace hop
+{
+
+LodWorker::LodWorker()
+{
+   _thread = std::thread( [this]() { run(); } );
+}
+
+LodWorker::~LodWorker()
+{
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _running = false;
+   }
+   _cv.notify_all();
+   _thread.join();
+}
+
+LodWorker::Slot& LodWorker::slot( uint32_t trackIdx, Kind kind )
+{
+   const size_t slotIdx = trackIdx * KIND_COUNT + kind;
+   if( slotIdx >= _slots.size() )
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      const size_t prevSize = _slots.size();
+      _slots.resize( ( trackIdx + 1 ) * KIND_COUNT );
+      for( size_t i = prevSize; i < _slots.size(); ++i )
+      {
+         _slots[i].reset( new Slot() );
+         _slots[i]->kind = (Kind)( i % KIND_COUNT );
+      }
+   }
+   return *_slots[slotIdx];
+}
+
+void LodWorker::submit( uint32_t trackIdx, Kind kind, const Entries& entries, const hop::Deque<Core_t>* cores )
+{
+   assert( ( kind == CORE_EVENTS ) == ( cores != nullptr ) );
+
+   Slot& s = slot( trackIdx, kind );
+   const size_t count = entries.ends.size();
+   if( count <= s.submittedCount ) return;
+
+   // Copy the new entries outside of the lock, as the worker cannot access the
+   // entries of the profiler while they are being appended to
+   const size_t from = s.submittedCount;
+   Entries newEntries;
+   newEntries.starts.append( entries.starts.begin() + from, entries.starts.end() );
+   newEntries.ends.append( entries.ends.begin() + from, entries.ends.end() );
+   newEntries.depths.append( entries.depths.begin() + from, entries.depths.end() );
+   newEntries.maxDepth = entries.maxDepth;
+   hop::Deque<Core_t> newCores;
+   if( cores ) newCores.append( cores->begin() + from, cores->end() );
+   s.submittedCount = count;
+
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      s.newEntries.append( std::move( newEntries ) );
+      s.newCores.append( std::move( newCores ) );
+      _hasWork = true;
+   }
+   _cv.notify_all();
+}
+
+bool LodWorker::collect( uint32_t trackIdx, Kind kind, LodsArray& lods )
+{
+   Slot& s = slot( trackIdx, kind );
+
+   LodsUpdate update;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      if( !s.hasUpdate ) return false;
+      std::swap( update.popCount, s.update.popCount );
+      for( int lodLvl = 0; lodLvl < LOD_COUNT; ++lodLvl )
+      {
+         update.lods[lodLvl].swap( s.update.lods[lodLvl] );
+      }
+      s.hasUpdate = false;
+   }
+
+   for( int lodLvl = 0; lodLvl < LOD_COUNT; ++lodLvl )
+   {
+      lods[lodLvl].pop_back( update.popCount[lodLvl] );
+      lods[lodLvl].append( std::move( update.lods[lodLvl] ) );
+   }
+   return true;
+}
+
+void LodWorker::clear()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   _cv.wait( lock, [this]() { return !_busy; } );
+   _slots.clear();
+   _hasWork = false;
+}
+
+void LodWorker::computeJob( Job& job, LodsUpdate& update )
+{
+   LodsData& data = job.slot->lodsData;
+
+   // The provisional LODs were already published, so the update must remove them
+   // before appending the new ones. The LODs of the data only hold the ones that
+   // were computed by this job.
+   update.popCount = data.provisionalCount;
+   data.provisionalCount = {};
+
+   if( job.slot->kind == CORE_EVENTS )
+      appendCoreEventLods( data, job.entries, job.cores );
+   else
+      appendLods( data, job.entries );
+
+   for( int lodLvl = 0; lodLvl < LOD_COUNT; ++lodLvl )
+   {
+      update.lods[lodLvl].swap( data.lods[lodLvl] );
+   }
+}
+
+void LodWorker::run()
+{
+   std::vector<Job> jobs;
+   std::vector<LodsUpdate> updates;
+   std::vector<size_t> jobOrder;
+   while( true )
+   {
+      {
+         std::unique_lock<std::mutex> lock( _mutex );
+         _busy = false;
+         _cv.notify_all();
+         _cv.wait( lock, [this]() { return _hasWork || !_running; } );
+         if( !_running ) break;
+
+         jobs.reserve( _slots.size() );
+         for( auto& s : _slots )
+         {
+            if( s->newEntries.ends.empty() ) continue;
+            jobs.emplace_back();
+            Job& job = jobs.back();
+            job.slot = s.get();
+            job.entries.starts.swap( s->newEntries.starts );
+            job.entries.ends.swap( s->newEntries.ends );
+            job.entries.depths.swap( s->newEntries.depths );
+            job.cores.swap( s->newCores );
+         }
+         _hasWork = false;
+         _busy    = true;
+      }
+
+      // The tracks do not depend on each other so they are processed in parallel by
+      // the thread pool of parallelFor. The biggest jobs are handed out first, so a
+      // big track does not start last and leave the other threads idle.
+      updates.clear();
+      updates.resize( jobs.size() );
+      jobOrder.resize( jobs.size() );
+      std::iota( jobOrder.begin(), jobOrder.end(), 0 );
+      std::sort( jobOrder.begin(), jobOrder.end(), [&jobs]( size_t lhs, size_t rhs ) {
+         return jobs[lhs].entries.ends.size() > jobs[rhs].entries.ends.size();
+      } );
+      parallelFor( jobs.size(), [&]( size_t i ) {
+         const size_t jobIdx = jobOrder[i];
+         computeJob( jobs[jobIdx], updates[jobIdx] );
+      } );
+
+      {
+         std::lock_guard<std::mutex> guard( _mutex );
+         for( size_t i = 0; i < jobs.size(); ++i )
+         {
+            LodsUpdate& dst = jobs[i].slot->update;
+            LodsUpdate& src = updates[i];
+            for( int lodLvl = 0; lodLvl < LOD_COUNT; ++lodLvl )
+            {
+               // Remove the provisional LODs that were not collected yet. The others
+               // will be removed by the collect.
+               const size_t popped = std::min<size_t>( src.popCount[lodLvl], dst.lods[lodLvl].size() );
+               dst.lods[lodLvl].pop_back( popped );
+               dst.popCount[lodLvl] += src.popCount[lodLvl] - popped;
+               dst.lods[lodLvl].append( std::move( src.lods[lodLvl] ) );
+            }
+            jobs[i].slot->hasUpdate = true;
+         }
+      }
+      jobs.clear();
+
+      _hasNewLods = true;
+      wakeUpMainLoop();
+   }
+}
+
+}  // namespace hop
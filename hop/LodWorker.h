@@ -0,0 +1,98 @@
+#ifndef LOD_WORKER_H_
+#define LOD_WORKER_H_
+
+#include "hop/Lod.h"
+#include "common/TraceData.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hop
+{
+
+// Computes the LODs of the tracks on a background thread. The UI thread submits the
+// entries added to a track and collects the LODs once they are ready, so it never
+// waits on their computation.
+class LodWorker
+{
+  public:
+   enum Kind
+   {
+      TRACES,
+      LOCKWAITS,
+      CORE_EVENTS,
+      KIND_COUNT
+   };
+
+   LodWorker();
+   ~LodWorker();
+
+   // Send the entries of the track that were not submitted yet. The cores must be
+   // provided for the core events.
+   void submit(
+       uint32_t trackIdx,
+       Kind kind,
+       const Entries& entries,
+       const hop::Deque<Core_t>* cores = nullptr );
+
+   // Update the lods with the ones computed since the last call.
+   // Returns true if they have changed.
+   bool collect( uint32_t trackIdx, Kind kind, LodsArray& lods );
+
+   // Returns true if LODs were computed since the last call
+   bool takeNewLodsFlag() { return _hasNewLods.exchange( false ); }
+
+   // Wait for the current computation and drop all the tracks
+   void clear();
+
+  private:
+   // LODs to apply on top of the collected ones
+   struct LodsUpdate
+   {
+      LodsArray lods;
+      // Number of collected LODs that were only provisional and must be removed first
+      std::array< size_t, LOD_COUNT > popCount{};
+   };
+
+   struct Slot
+   {
+      Kind kind;
+      size_t submittedCount{0};  // Only used by the UI thread
+
+      // Protected by the mutex
+      Entries newEntries;
+      hop::Deque< Core_t > newCores;
+      LodsUpdate update;
+      bool hasUpdate{false};
+
+      LodsData lodsData;  // Only used by the worker thread
+   };
+
+   struct Job
+   {
+      Slot* slot;
+      Entries entries;
+      hop::Deque< Core_t > cores;
+   };
+
+   Slot& slot( uint32_t trackIdx, Kind kind );
+   void run();
+   void computeJob( Job& job, LodsUpdate& update );
+
+   std::vector< std::unique_ptr< Slot > > _slots;  // Indexed by track * KIND_COUNT + kind
+   std::mutex _mutex;
+   std::condition_variable _cv;
+   std::thread _thread;
+   bool _hasWork{false};
+   bool _busy{false};
+   bool _running{true};
+   std::atomic<bool> _hasNewLods{false};
+};
+
+}  // namespace hop
+
+#endif  // LOD_WORKER_H_
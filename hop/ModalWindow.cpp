@@ -1,4 +1,5 @@
 #include "hop/ModalWindow.h"
+#include "common/Utils.h"
 
 #include "imgui/imgui.h"
 
@@ -207,6 +208,7 @@ void displayModalWindow( const char* windowTitle, const char* message, ModalType
    shouldCloseModalWindow = false;
    modalWindowTitle       = windowTitle;
    modalWindowMessage     = message;
+   wakeUpMainLoop();
 }
 
 void displayModalWindow( const char* windowTitle, const char* message, ModalType type, std::function<void()> fctToExec )
@@ -241,5 +243,6 @@ void closeModalWindow()
 {
    std::lock_guard<std::mutex> g( modalWindowLock );
    shouldCloseModalWindow = true;
+   wakeUpMainLoop();
 }
 }  // namespace hop
\ No newline at end of file
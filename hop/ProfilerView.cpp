@@ -42,10 +42,12 @@ hop::ProfilerView::ProfilerView( hop::Profiler::SourceType type, int processId,
 
 bool hop::ProfilerView::fetchClientData()
 {
-   return _profiler.fetchClientData();
+   const bool gotData = _profiler.fetchClientData();
+   _newData |= gotData;
+   return gotData;
 }
 
-void hop::ProfilerView::update( float globalTimeMs, TimeDuration timelineDuration )
+bool hop::ProfilerView::update( float globalTimeMs, TimeDuration timelineDuration )
 {
    HOP_PROF_FUNC();
    _highlightValue = (std::sin( 0.007f * globalTimeMs ) * 0.8f + 1.0f) / 2.0f;
@@ -53,7 +55,9 @@ void hop::ProfilerView::update( float globalTimeMs, TimeDuration timelineDuratio
    // Update current lod level
    _lodLevel = closestLodLevel( timelineDuration );
 
-   _trackViews.update( _profiler );
+   const bool changed = _trackViews.update( _profiler, _newData );
+   _newData = false;
+   return changed;
 }
 
 void hop::ProfilerView::setRecording( bool recording )
@@ -68,23 +72,46 @@ bool hop::ProfilerView::saveToFile( const char* path )
 
 bool hop::ProfilerView::openFile( const char* path )
 {
+   _newData = true;
    return _profiler.openFile( path );
 }
 
+bool hop::ProfilerView::loadChunksUntil( TimeStamp time )
+{
+   const bool loaded = _profiler.loadChunksUntil( time );
+   _newData |= loaded;
+   return loaded;
+}
+
 bool hop::ProfilerView::draw( float drawPosX, float drawPosY, const TimelineInfo& tlInfo, TimelineMsgArray* msgArray )
 {
    HOP_PROF_FUNC();
    ImGui::SetCursorPos( ImVec2( drawPosX, drawPosY ) );
 
+   // The queries over the whole capture would miss the chunks of a lazily opened
+   // file that were not loaded yet
    bool needs_redraw = false;
+   if( _trackViews.needsWholeCapture() && !_profiler.fullyLoaded() )
+   {
+      _profiler.loadAllChunks();
+      _newData     = true;
+      needs_redraw = true;
+   }
+
    if ( _trackViews.count() > 0 )
    {
       TimelineTrackDrawData drawData = { _profiler, tlInfo, _lodLevel, _highlightValue };
-      needs_redraw = _trackViews.draw( drawData, msgArray );
+      needs_redraw |= _trackViews.draw( drawData, msgArray );
    }
    return needs_redraw;
 }
 
+void hop::ProfilerView::drawMinimap( const TimelineInfo& tlInfo, TimelineMsgArray* msgArray )
+{
+   TimelineTrackDrawData drawData = { _profiler, tlInfo, _lodLevel, _highlightValue };
+   _trackViews.drawMinimap( drawData, msgArray );
+}
+
 bool hop::ProfilerView::handleHotkey()
 {
    bool handled = false;
@@ -118,6 +145,7 @@ void hop::ProfilerView::clear()
 {
    _profiler.clear();
    _trackViews.clear();
+   _newData = true;
 }
 
 float hop::ProfilerView::canvasHeight() const
@@ -17,8 +17,10 @@ class ProfilerView
 public:
    ProfilerView( Profiler::SourceType type, int processId, const char* str );
    bool fetchClientData();
-   void update( float globalTimeMs, TimeDuration timelineDuration );
+   // Returns true if the tracks have changed
+   bool update( float globalTimeMs, TimeDuration timelineDuration );
    bool draw( float drawPosX, float drawPosY, const TimelineInfo& tlInfo, TimelineMsgArray* msgArray );
+   void drawMinimap( const TimelineInfo& tlInfo, TimelineMsgArray* msgArray );
 
    bool handleHotkey();
    bool handleMouse( float posX, float posY, bool lmClicked, bool rmClicked, float wheel );
@@ -28,6 +30,7 @@ public:
 
    bool saveToFile( const char* path );
    bool openFile( const char* path );
+   bool loadChunksUntil( TimeStamp time );
 
    float canvasHeight() const;
    int lodLevel() const;
@@ -37,6 +40,7 @@ private:
    TimelineTracksView _trackViews;
    int _lodLevel;
    float _highlightValue;
+   bool _newData{false};  // Data was added since the last update
 };
 
 } // namespace hop
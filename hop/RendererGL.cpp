@@ -2,6 +2,8 @@
 
 #include "imgui/imgui.h"
 
+#include <deque>
+
 #ifdef _MSC_VER
 #include <windows.h>
 #endif
@@ -18,6 +20,23 @@ namespace renderer
 
 uint32_t g_FontTexture = 0;
 
+struct RectBatch
+{
+   std::vector<RectInstance> rects;
+   float height;
+};
+
+// The batches are kept between the frames so their memory is reused
+static std::deque<RectBatch> g_rectBatches;
+static size_t g_rectBatchCount = 0;
+static int g_fbHeight          = 0;
+
+struct RectVertex
+{
+   float x, y;
+   uint32_t color;
+};
+
 void setViewport( uint32_t x, uint32_t y, uint32_t width, uint32_t height )
 {
    glViewport( x, y, width, height );
@@ -29,6 +48,77 @@ void clearColorBuffer()
    glClear( GL_COLOR_BUFFER_BIT );
 }
 
+// Expand the rectangles of the batch to quads and draw them all at once
+static void drawRectBatch( const ImDrawList*, const ImDrawCmd* cmd )
+{
+   static std::vector<RectVertex> vertices;
+
+   const RectBatch& batch = g_rectBatches[(size_t)(intptr_t)cmd->UserCallbackData];
+   if( batch.rects.empty() ) return;
+
+   vertices.resize( batch.rects.size() * 4 );
+   RectVertex* v = vertices.data();
+   for( const RectInstance& r : batch.rects )
+   {
+      const float right  = r.x + r.width;
+      const float bottom = r.y + batch.height;
+      v[0] = RectVertex{r.x, r.y, r.color};
+      v[1] = RectVertex{right, r.y, r.color};
+      v[2] = RectVertex{right, bottom, r.color};
+      v[3] = RectVertex{r.x, bottom, r.color};
+      v += 4;
+   }
+
+   glScissor(
+       (int)cmd->ClipRect.x,
+       (int)( g_fbHeight - cmd->ClipRect.w ),
+       (int)( cmd->ClipRect.z - cmd->ClipRect.x ),
+       (int)( cmd->ClipRect.w - cmd->ClipRect.y ) );
+
+   // The rectangles are not textured
+   glDisable( GL_TEXTURE_2D );
+   glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+   glVertexPointer( 2, GL_FLOAT, sizeof( RectVertex ), &vertices[0].x );
+   glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof( RectVertex ), &vertices[0].color );
+   glDrawArrays( GL_QUADS, 0, (GLsizei)vertices.size() );
+   glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+   glEnable( GL_TEXTURE_2D );
+}
+
+std::vector<RectInstance>& addRectBatch( ImDrawList* drawList, float height )
+{
+   if( g_rectBatchCount == g_rectBatches.size() ) g_rectBatches.emplace_back();
+
+   RectBatch& batch = g_rectBatches[g_rectBatchCount];
+   batch.rects.clear();
+   batch.height = height;
+   drawList->AddCallback( drawRectBatch, (void*)(intptr_t)g_rectBatchCount );
+   ++g_rectBatchCount;
+
+   return batch.rects;
+}
+
+#define OFFSETOF( TYPE, ELEMENT ) ( ( size_t ) & ( ( (TYPE*)0 )->ELEMENT ) )
+static void setVertexPointers( const ImDrawVert* vtx_buffer )
+{
+   glVertexPointer(
+       2,
+       GL_FLOAT,
+       sizeof( ImDrawVert ),
+       (const GLvoid*)( (const char*)vtx_buffer + OFFSETOF( ImDrawVert, pos ) ) );
+   glTexCoordPointer(
+       2,
+       GL_FLOAT,
+       sizeof( ImDrawVert ),
+       (const GLvoid*)( (const char*)vtx_buffer + OFFSETOF( ImDrawVert, uv ) ) );
+   glColorPointer(
+       4,
+       GL_UNSIGNED_BYTE,
+       sizeof( ImDrawVert ),
+       (const GLvoid*)( (const char*)vtx_buffer + OFFSETOF( ImDrawVert, col ) ) );
+}
+#undef OFFSETOF
+
 // This is the main rendering function that you have to implement and provide to ImGui (via setting
 // up 'RenderDrawListsFn' in the ImGuiIO structure)
 // If text or lines are blurry when integrating ImGui in your engine:
@@ -41,8 +131,13 @@ void renderDrawlist( ImDrawData* draw_data )
    ImGuiIO& io = ImGui::GetIO();
    int fb_width = (int)( io.DisplaySize.x * io.DisplayFramebufferScale.x );
    int fb_height = (int)( io.DisplaySize.y * io.DisplayFramebufferScale.y );
-   if ( fb_width == 0 || fb_height == 0 ) return;
+   if ( fb_width == 0 || fb_height == 0 )
+   {
+      g_rectBatchCount = 0;
+      return;
+   }
    draw_data->ScaleClipRects( io.DisplayFramebufferScale );
+   g_fbHeight = fb_height;
 
    // We are using the OpenGL fixed pipeline to make the example code simpler to read!
    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor
@@ -74,27 +169,12 @@ void renderDrawlist( ImDrawData* draw_data )
    glLoadIdentity();
 
 // Render command lists
-#define OFFSETOF( TYPE, ELEMENT ) ( ( size_t ) & ( ( (TYPE*)0 )->ELEMENT ) )
    for ( int n = 0; n < draw_data->CmdListsCount; n++ )
    {
       const ImDrawList* cmd_list = draw_data->CmdLists[n];
       const ImDrawVert* vtx_buffer = cmd_list->VtxBuffer.Data;
       const ImDrawIdx* idx_buffer = cmd_list->IdxBuffer.Data;
-      glVertexPointer(
-          2,
-          GL_FLOAT,
-          sizeof( ImDrawVert ),
-          (const GLvoid*)( (const char*)vtx_buffer + OFFSETOF( ImDrawVert, pos ) ) );
-      glTexCoordPointer(
-          2,
-          GL_FLOAT,
-          sizeof( ImDrawVert ),
-          (const GLvoid*)( (const char*)vtx_buffer + OFFSETOF( ImDrawVert, uv ) ) );
-      glColorPointer(
-          4,
-          GL_UNSIGNED_BYTE,
-          sizeof( ImDrawVert ),
-          (const GLvoid*)( (const char*)vtx_buffer + OFFSETOF( ImDrawVert, col ) ) );
+      setVertexPointers( vtx_buffer );
 
       for ( int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++ )
       {
@@ -102,6 +182,8 @@ void renderDrawlist( ImDrawData* draw_data )
          if ( pcmd->UserCallback )
          {
             pcmd->UserCallback( cmd_list, pcmd );
+            // The callback can use its own vertex data
+            setVertexPointers( vtx_buffer );
          }
          else
          {
@@ -120,7 +202,7 @@ void renderDrawlist( ImDrawData* draw_data )
          idx_buffer += pcmd->ElemCount;
       }
    }
-#undef OFFSETOF
+   g_rectBatchCount = 0;
 
    // Restore modified state
    glDisableClientState( GL_COLOR_ARRAY );
@@ -2,8 +2,10 @@
 #define RENDERER_GL_H_
 
 #include <cstdint>
+#include <vector>
 
 struct ImDrawData;
+struct ImDrawList;
 
 namespace renderer
 {
@@ -16,6 +18,17 @@ void renderDrawlist( ImDrawData* draw_data );
 void createResources();
 void setVSync( bool on );
 
+struct RectInstance
+{
+   float x, y, width;
+   uint32_t color;
+};
+
+// Add a batch of filled rectangles of the same height to the draw list and return it
+// so it can be filled. The whole batch is rendered with a single draw call, in order
+// with the other primitives of the draw list. It stays valid until the next render.
+std::vector<RectInstance>& addRectBatch( ImDrawList* drawList, float height );
+
 } // namespace renderer
 
 #endif // RENDERER_GL_H_
\ No newline at end of file
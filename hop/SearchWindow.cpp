@@ -9,6 +9,7 @@
 
 #include "imgui/imgui.h"
 
+#include <algorithm>
 #include <functional> //std::greater
 
 template <typename CMP>
@@ -98,28 +99,85 @@ void findTraces( const char* string, const StringDb& strDb, const std::vector<ho
    result.stringSearched = string;
    result.matchCount = 0;
    result.tracesIdxThreadIdx.clear();
-   result.tracesIdxThreadIdx.reserve(512);
 
-   auto strIds = strDb.findStringIndexMatching( string );
-   for( uint32_t threadIdx = 0; threadIdx < tracks.size(); ++threadIdx )
+   // Strings are aligned on 8 bytes in the db, so one bit per 8 bytes is enough to
+   // flag the matching ones
+   const auto strIds = strDb.findStringIndexMatching( string );
+   std::vector<bool> matchingStrings( strDb.sizeInBytes() / 8 + 1, false );
+   for( size_t id : strIds )
+      matchingStrings[id / 8] = true;
+
+   struct Match
+   {
+      TimeDuration duration;
+      size_t traceIdx;
+      uint32_t threadIdx;
+   };
+   // The longest first. The traces of a callsite are gathered in no particular order,
+   // so the ties are ordered on the thread and the trace index to always give the same
+   // results.
+   const auto longestFirst = []( const Match& lhs, const Match& rhs ) {
+      if( lhs.duration != rhs.duration ) return lhs.duration > rhs.duration;
+      if( lhs.threadIdx != rhs.threadIdx ) return lhs.threadIdx < rhs.threadIdx;
+      return lhs.traceIdx < rhs.traceIdx;
+   };
+
+   // Gather and sort the matches of each track on their own thread, so the results
+   // only need to be merged afterward
+   std::vector<std::vector<Match> > matchesPerTrack( tracks.size() );
+   parallelFor( tracks.size(), [&]( size_t threadIdx ) {
+      const TimelineTrack& ti = tracks[threadIdx];
+      std::vector<Match>& matches = matchesPerTrack[threadIdx];
+      for( const auto& callsite : ti._tracesPerCallsite )
+      {
+         const size_t strIdx = callsite.first.fctName / 8;
+         if( strIdx >= matchingStrings.size() || !matchingStrings[strIdx] ) continue;
+
+         for( size_t traceIdx : callsite.second )
+         {
+            const TimeDuration duration = ti._traces.entries.ends[traceIdx] - ti._traces.entries.starts[traceIdx];
+            matches.push_back( Match{duration, traceIdx, (uint32_t)threadIdx} );
+         }
+      }
+      std::sort( matches.begin(), matches.end(), longestFirst );
+   } );
+
+   // Merge all the tracks at once, using a heap of the next match of each track
+   struct Cursor
+   {
+      const Match* cur;
+      const Match* end;
+   };
+   const auto heapCmp = [&longestFirst]( const Cursor& lhs, const Cursor& rhs ) {
+      return longestFirst( *rhs.cur, *lhs.cur );
+   };
+   std::vector<Cursor> heap;
+   size_t totalCount = 0;
+   for( const auto& matches : matchesPerTrack )
+   {
+      if( matches.empty() ) continue;
+      heap.push_back( Cursor{matches.data(), matches.data() + matches.size()} );
+      totalCount += matches.size();
+   }
+   std::make_heap( heap.begin(), heap.end(), heapCmp );
+
+   std::vector<Match> merged;
+   merged.reserve( totalCount );
+   while( !heap.empty() )
    {
-       const auto& ti = tracks[ threadIdx ];
-       for( size_t idx = 0; idx < ti._traces.fctNameIds.size(); ++idx )
-       {
-          const size_t fctNameId = ti._traces.fctNameIds[ idx ];
-          for( auto i : strIds )
-          {
-             if ( i == fctNameId )
-             {
-                result.tracesIdxThreadIdx.emplace_back( idx, threadIdx );
-                ++result.matchCount;
-             }
-          }
-       }
+      std::pop_heap( heap.begin(), heap.end(), heapCmp );
+      Cursor& next = heap.back();
+      merged.push_back( *next.cur );
+      if( ++next.cur == next.end )
+         heap.pop_back();
+      else
+         std::push_heap( heap.begin(), heap.end(), heapCmp );
    }
 
-   // Sort them by duration
-   sortSearchResOnDuration( result, tracks, std::greater<TimeStamp>() );
+   result.tracesIdxThreadIdx.reserve( merged.size() );
+   for( const Match& m : merged )
+      result.tracesIdxThreadIdx.emplace_back( m.traceIdx, m.threadIdx );
+   result.matchCount = merged.size();
 }
 
 SearchSelection drawSearchResult(
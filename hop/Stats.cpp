@@ -7,7 +7,7 @@
 namespace hop
 {
 
-Stats g_stats = { 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, 0, 0, 0, 0 };
+Stats g_stats = { 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 void drawStatsWindow( const Stats& stats )
 {
@@ -34,6 +34,7 @@ void drawStatsWindow( const Stats& stats )
    formatSizeInBytesToDisplay( stats.stringDbSize, formatStr, sizeof(formatStr) );
    ImGui::Text("String Db size : %s", formatStr);
    ImGui::Text("Traces count : %zu", stats.traceCount);
+   ImGui::Text("Dropped messages : %zu (%zu traces)", stats.droppedMsgCount, stats.droppedTraceCount);
    ImGui::Text("Current LOD : %d", stats.currentLOD);
 }
 
@@ -19,6 +19,8 @@ namespace hop
       size_t stringDbSize;
       size_t traceCount;
       size_t clientSharedMemSize;
+      size_t droppedMsgCount;
+      size_t droppedTraceCount;
    };
 
    extern Stats g_stats;
@@ -623,6 +623,11 @@ void Timeline::handleDeferredActions( const TimelineMsgArray& messages )
          case TimelineMessageType::MOVE_TO_PRESENT_TIME:
             moveToPresentTime( ANIMATION_TYPE_NONE );
             break;
+         case TimelineMessageType::MOVE_TO_ABSOLUTE_TIME:
+            if( m.frameToTime.pushNavState ) pushNavigationState();
+            setRealtime( false );
+            moveToAbsoluteTime( m.frameToTime.time, ANIMATION_TYPE_NONE );
+            break;
       }
    }
 }
@@ -26,6 +26,7 @@ namespace hop
       FRAME_TO_TIME,
       FRAME_TO_ABSOLUTE_TIME,
       MOVE_TO_PRESENT_TIME,
+      MOVE_TO_ABSOLUTE_TIME,
       MOVE_VERTICAL_POS_PXL
    };
 
@@ -81,6 +82,15 @@ namespace hop
          msg->verticalPos.withAnimation = withAnimation;
       }
 
+      void addMoveToAbsoluteTimeMsg( TimeStamp time, bool pushNavState )
+      {
+         assert( count < MAX_MSG_COUNT );
+         TimelineMessage* msg = &messages[count++];
+         msg->type = TimelineMessageType::MOVE_TO_ABSOLUTE_TIME;
+         msg->frameToTime.time = time;
+         msg->frameToTime.pushNavState = pushNavState;
+      }
+
       void addMoveToPresentTimeMsg()
       {
          assert( count < MAX_MSG_COUNT );
@@ -12,10 +12,13 @@
 #include "hop/Options.h"
 #include "hop/Stats.h"
 #include "hop/Lod.h"
+#include "hop/RendererGL.h"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
 
+#include <cmath>
+
 // Drawing constants
 static constexpr float THREAD_LABEL_HEIGHT        = 20.0f;
 static constexpr float MIN_PXL_SIZE_FOR_TEXT      = 5.0f;
@@ -25,6 +28,12 @@ static constexpr uint32_t SEPARATOR_HANDLE_COLOR  = 0xFFAAAAAA;
 static constexpr uint32_t LOCK_WAIT_COLOR         = 0XFF0000FF;
 static constexpr uint32_t CORE_LABEL_COLOR        = 0xFF333333;
 static constexpr uint32_t CORE_LABEL_BORDER_COLOR = 0xFFAAAAAA;
+static constexpr float MINIMAP_HEIGHT                 = 30.0f;
+static constexpr float MINIMAP_MIN_VISIBLE_WIDTH      = 2.0f;
+static constexpr uint32_t MINIMAP_BG_COLOR            = 0xFF1A1A1A;
+static constexpr uint32_t MINIMAP_ACTIVITY_COLOR      = 0x0000B4FF; // Without alpha
+static constexpr uint32_t MINIMAP_VISIBLE_RANGE_COLOR = 0xCCFFFFFF;
+static constexpr uint32_t MINIMAP_PARTIAL_TEXT_COLOR  = 0xAAFFFFFF;
 static const char* CTXT_MENU_STR = "Context Menu";
 
 // Static variable mutable from options
@@ -184,6 +193,48 @@ static void createDrawData(
    }
 }
 
+// Collapse the entries starting in the same pixel column at the same depth into the first
+// one, so at most one rectangle is drawn per column and depth. The longest entry of each
+// group is kept so it is the one labeled and hovered. The arrays are compacted in place.
+// Returns the number of entries left.
+template <typename LodIt>
+static size_t cullSubPixelEntries(
+    LodIt it,
+    size_t count,
+    float* __restrict startsPxl,
+    float* __restrict deltaPxl,
+    std::vector<hop::LodInfo>& lods )
+{
+   HOP_PROF_FUNC();
+
+   // Last entry kept for each depth
+   static std::vector<size_t> lastKept;
+   std::fill( lastKept.begin(), lastKept.end(), hop::INVALID_IDX );
+
+   lods.clear();
+   for( size_t i = 0; i < count; ++i, ++it )
+   {
+      const hop::LodInfo& lod = *it;
+      if( lod.depth >= lastKept.size() ) lastKept.resize( lod.depth + 1, hop::INVALID_IDX );
+
+      const size_t kept = lastKept[lod.depth];
+      if( kept != hop::INVALID_IDX && (int64_t)startsPxl[i] == (int64_t)startsPxl[kept] )
+      {
+         const float endPxl = std::max( startsPxl[kept] + deltaPxl[kept], startsPxl[i] + deltaPxl[i] );
+         deltaPxl[kept]     = endPxl - startsPxl[kept];
+         if( lod.end - lod.start > lods[kept].end - lods[kept].start ) lods[kept] = lod;
+         continue;
+      }
+
+      const size_t dst    = lods.size();
+      startsPxl[dst]      = startsPxl[i];
+      deltaPxl[dst]       = deltaPxl[i];
+      lastKept[lod.depth] = dst;
+      lods.push_back( lod );
+   }
+   return lods.size();
+}
+
 /*
    Customization point for the draw entries function
 */
@@ -317,14 +368,34 @@ struct DrawEntriesInfo
    bool          drawLodedText;
 };
 
+// The labels do not depend on the zoom level, but they are only kept for a range of zoom
+// levels and a maximum count so the cache does not grow with every entry ever drawn
+static void validateLabelCache( hop::TimelineTracksView::LabelCache& cache, const hop::TimelineTrackDrawData& data )
+{
+   static constexpr size_t MAX_CACHED_LABELS = 1 << 16;
+
+   const int zoomBucket   = std::ilogb( (double)std::max<hop::TimeDuration>( data.timeline.duration, 1 ) );
+   const float cpuFreqGHz = data.profiler.cpuFreqGHz();
+   if( cache.zoomBucket != zoomBucket || cache.useCycles != data.timeline.useCycles ||
+       cache.cpuFreqGHz != cpuFreqGHz || cache.labels.size() > MAX_CACHED_LABELS )
+   {
+      cache.labels.clear();
+      cache.zoomBucket = zoomBucket;
+      cache.useCycles  = data.timeline.useCycles;
+      cache.cpuFreqGHz = cpuFreqGHz;
+   }
+}
+
 static size_t drawEntries(
     const ImVec2 drawPos,
     uint32_t threadIndex,
     const hop::TimelineTrackDrawData& data,
-    const hop::LodsData& lodsData,
+    const hop::LodsArray& lods,
+    hop::TimelineTracksView::LabelCache& labels,
     const DrawEntriesInfo& drawInfo )
 {
    using namespace hop;
+   using LabelCache = TimelineTracksView::LabelCache;
 
    // Get all the timing boundaries
    const TimeStamp globalStartTime  = data.timeline.globalStartTime;
@@ -336,25 +407,43 @@ static size_t drawEntries(
 
    // The time range to draw in absolute time
    const auto spanIndex =
-      hop::visibleIndexSpan( lodsData.lods, data.lodLevel, absoluteStart, absoluteEnd, 0 );
+      hop::visibleIndexSpan( lods, data.lodLevel, absoluteStart, absoluteEnd, 0 );
 
    if( spanIndex.first == hop::INVALID_IDX ) return hop::INVALID_IDX;
 
    static std::vector< float > startPosPxl;
    static std::vector< float > deltaPxl;
+   static std::vector< LodInfo > visibleLods;
 
-   const size_t traceCount = spanIndex.second - spanIndex.first;
-   startPosPxl.resize( traceCount );
-   deltaPxl.resize( traceCount );
+   const size_t lodCount = spanIndex.second - spanIndex.first;
+   startPosPxl.resize( lodCount );
+   deltaPxl.resize( lodCount );
 
    const float windowWidthPxl = ImGui::GetWindowWidth();
 
-   auto lodStartIt = lodsData.lods[data.lodLevel].begin() + spanIndex.first;
-   createDrawData( lodStartIt, traceCount, absoluteStart, timelineRange / windowWidthPxl, startPosPxl.data(), deltaPxl.data() );
+   auto lodStartIt = lods[data.lodLevel].begin() + spanIndex.first;
+   createDrawData( lodStartIt, lodCount, absoluteStart, timelineRange / windowWidthPxl, startPosPxl.data(), deltaPxl.data() );
+   const size_t traceCount =
+       cullSubPixelEntries( lodStartIt, lodCount, startPosPxl.data(), deltaPxl.data(), visibleLods );
 
    const ImVec2 mousePos    = ImGui::GetMousePos();
    const ImVec2 framePading = ImGui::GetStyle().FramePadding;
 
+   validateLabelCache( labels, data );
+
+   // Draw all the frames at once before their labels
+   ImDrawList* drawList = ImGui::GetWindowDrawList();
+   std::vector<renderer::RectInstance>& rects = renderer::addRectBatch( drawList, PADDED_TRACE_SIZE );
+   rects.resize( traceCount );
+   for( size_t i = 0; i < traceCount; ++i )
+   {
+      const LodInfo& curLod = visibleLods[i];
+      rects[i] = renderer::RectInstance{ startPosPxl[i],
+                                         drawPos.y + curLod.depth * PADDED_TRACE_SIZE,
+                                         deltaPxl[i],
+                                         drawInfo.getEntryColor( data, threadIndex, curLod.index ) };
+   }
+
    const bool drawLodedText = drawInfo.drawLodedText;
    const bool withBorder    = drawInfo.borderSize > 0.0f;
    if( withBorder )
@@ -367,20 +456,29 @@ static size_t drawEntries(
    size_t hoveredLodIdx = hop::INVALID_IDX;
    for( size_t i = 0; i < traceCount; ++i )
    {
-      const LodInfo& curLod = *(lodStartIt + i);
+      const LodInfo& curLod = visibleLods[i];
       const size_t absIndex = curLod.index;
 
       const ImVec2 from( startPosPxl[i], drawPos.y + curLod.depth * PADDED_TRACE_SIZE );
       const ImVec2 to( from + ImVec2( deltaPxl[i], PADDED_TRACE_SIZE ) );
-      ImGui::RenderFrame( from, to, drawInfo.getEntryColor( data, threadIndex, absIndex ), withBorder );
+      if( withBorder ) ImGui::RenderFrameBorder( from, to );
 
-      // Create the name for the trace if it is large enough on screen
-      entryName[0] = '\0';
+      // Draw the name of the trace if it is large enough on screen. It is only created
+      // if it was not drawn in the previous frames
       if( deltaPxl[i] > MIN_PXL_SIZE_FOR_TEXT && ( !curLod.loded || drawLodedText ) )
       {
-         drawInfo.getEntryLabelFct( data, threadIndex, absIndex, curLod.end - curLod.start, sizeof(entryName), entryName );
-         ImVec2 labelSize = ImGui::CalcTextSize(entryName, NULL, true);
-         ImGui::RenderTextClipped( from + framePading, to - framePading, entryName, NULL, &labelSize, drawInfo.textAlign, nullptr );
+         const TimeDuration duration = curLod.end - curLod.start;
+         const auto inserted = labels.labels.emplace( LabelCache::Key{absIndex, duration}, LabelCache::Label{} );
+         LabelCache::Label& label = inserted.first->second;
+         if( inserted.second )
+         {
+            drawInfo.getEntryLabelFct( data, threadIndex, absIndex, duration, sizeof(entryName), entryName );
+            const ImVec2 size = ImGui::CalcTextSize( entryName, NULL, true );
+            label             = LabelCache::Label{entryName, size.x, size.y};
+         }
+         ImVec2 labelSize( label.width, label.height );
+         const char* text = label.text.c_str();
+         ImGui::RenderTextClipped( from + framePading, to - framePading, text, text + label.text.size(), &labelSize, drawInfo.textAlign, nullptr );
 
          // Keep the index around if the mouse is inside the drawing
          if( hop::ptInRect( mousePos.x, mousePos.y, from.x, from.y, to.x, to.y ) )
@@ -399,21 +497,22 @@ static size_t drawEntries(
    startPosPxl.clear();
    deltaPxl.clear();
 
-   return hoveredLodIdx == hop::INVALID_IDX ? hop::INVALID_IDX : (lodStartIt + hoveredLodIdx)->index;
+   return hoveredLodIdx == hop::INVALID_IDX ? hop::INVALID_IDX : visibleLods[hoveredLodIdx].index;
 }
 
 static size_t drawCoreLabels(
     const ImVec2 drawPos,
     uint32_t threadIdx,
     const hop::TimelineTrackDrawData& data,
-    const hop::LodsData& lodsData )
+    const hop::LodsArray& lods,
+    hop::TimelineTracksView::LabelCache& labels )
 {
    HOP_PROF_FUNC();
 
    const auto drawStart = std::chrono::system_clock::now();
 
    const DrawEntriesInfo drawInfo = {coreEventLabel, getCoreEventColor, ImVec2( 0.5f, 0.5f ), 2.0f, true};
-   const size_t hoveredIdx        = drawEntries( drawPos, threadIdx, data, lodsData, drawInfo );
+   const size_t hoveredIdx        = drawEntries( drawPos, threadIdx, data, lods, labels, drawInfo );
 
    const auto drawEnd = std::chrono::system_clock::now();
    hop::g_stats.coreDrawingTimeMs +=
@@ -426,7 +525,8 @@ static size_t drawLockWaits(
     const ImVec2 drawPos,
     uint32_t threadIdx,
     const hop::TimelineTrackDrawData& data,
-    const hop::LodsData& lodsData )
+    const hop::LodsArray& lods,
+    hop::TimelineTracksView::LabelCache& labels )
 {
    const auto drawStart = std::chrono::system_clock::now();
 
@@ -434,7 +534,7 @@ static size_t drawLockWaits(
 
    DrawEntriesInfo drawInfo = {
        lockwaitLabelWithTime, getLockWaitColor, ImVec2( textAlignment, 0.5f ), 0.0f, false};
-   const size_t hoveredIdx  = drawEntries( drawPos, threadIdx, data, lodsData, drawInfo );
+   const size_t hoveredIdx  = drawEntries( drawPos, threadIdx, data, lods, labels, drawInfo );
 
    const auto drawEnd = std::chrono::system_clock::now();
    hop::g_stats.lockwaitsDrawingTimeMs +=
@@ -447,7 +547,8 @@ static size_t drawTraces(
     const ImVec2 drawPos,
     uint32_t threadIdx,
     const hop::TimelineTrackDrawData& data,
-    const hop::LodsData& lodsData )
+    const hop::LodsArray& lods,
+    hop::TimelineTracksView::LabelCache& labels )
 {
    const auto drawStart = std::chrono::system_clock::now();
 
@@ -456,7 +557,7 @@ static size_t drawTraces(
    DrawEntriesInfo drawInfo = {
        traceLabelWithTime, getTraceColor, ImVec2( textAlignment, 0.5f ), 0.0f, false};
    // Draw the lock waits  entries (before traces so that they are not hiding them)
-   const size_t hoveredIdx = drawEntries( drawPos, threadIdx, data, lodsData, drawInfo );
+   const size_t hoveredIdx = drawEntries( drawPos, threadIdx, data, lods, labels, drawInfo );
 
    const auto drawEnd = std::chrono::system_clock::now();
    hop::g_stats.traceDrawingTimeMs +=
@@ -712,8 +813,12 @@ float TimelineTracksView::trackAbsoluteDrawPosY( uint32_t trackIdx ) const
    return _tracks[trackIdx].absoluteDrawPos[1];
 }
 
-void TimelineTracksView::update( const hop::Profiler& profiler )
+bool TimelineTracksView::update( const hop::Profiler& profiler, bool newData )
 {
+   // Nothing to do if there is no new data to send to the LOD worker and no LOD to fetch
+   const bool newLods = _lodWorker.takeNewLodsFlag();
+   if( !newData && !newLods ) return false;
+
    HOP_PROF_FUNC();
 
    const auto updateStart = std::chrono::system_clock::now();
@@ -728,40 +833,49 @@ void TimelineTracksView::update( const hop::Profiler& profiler )
       }
    }
 
-   // Then update their lods
+   // Then send the new entries to the LOD worker and fetch the LODs it has computed
+   bool changed = newData;
    const size_t trackCount = _tracks.size();
    for( size_t i = 0; i < trackCount; ++i )
    {
       const TimelineTrack& track = profiler.timelineTracks()[i];
+      TrackViewData& trackView   = _tracks[i];
 
-      // Create the LOD for the traces
+      // LODs for the traces
       const hop::Entries& traceEntries = track._traces.entries;
-      appendLods( _tracks[i].traceLodsData, traceEntries );
+      changed |= _lodWorker.collect( i, LodWorker::TRACES, trackView.traceLods );
+      _lodWorker.submit( i, LodWorker::TRACES, traceEntries );
 
-      // Create LOD for the lockwaits
+      // Busy time of the new traces, for the minimap
+      appendActivity( trackView.activity, traceEntries );
+
+      // LODs for the lockwaits
       const hop::Entries& lwEntries = track._lockWaits.entries;
-      appendLods( _tracks[i].lockwaitsLodsData, lwEntries );
+      changed |= _lodWorker.collect( i, LodWorker::LOCKWAITS, trackView.lockwaitLods );
+      _lodWorker.submit( i, LodWorker::LOCKWAITS, lwEntries );
 
-      // Create LOD for the core events
-      const hop::Entries& coreEntries = track._coreEvents.entries;
-      appendCoreEventLods( _tracks[i].coreEventLodsData, coreEntries, track._coreEvents.cores );
+      // LODs for the core events
+      changed |= _lodWorker.collect( i, LodWorker::CORE_EVENTS, trackView.coreEventLods );
+      _lodWorker.submit( i, LodWorker::CORE_EVENTS, track._coreEvents.entries, &track._coreEvents.cores );
 
       // Update max depth as well in case it has changed
       const Depth_t newMaxDepth = std::max( traceEntries.maxDepth, lwEntries.maxDepth );
-      _tracks[i].maxDepth       = newMaxDepth;
+      trackView.maxDepth        = newMaxDepth;
    }
 
-   // Finally update according to the options
-   TRACE_HEIGHT = hop::options::traceHeight();
-   PADDED_TRACE_SIZE = TRACE_HEIGHT + TRACE_VERTICAL_PADDING;
-
    const auto updateEnd = std::chrono::system_clock::now();
    hop::g_stats.updatingTimeMs +=
        std::chrono::duration<double, std::milli>( ( updateEnd - updateStart ) ).count();
+
+   return changed;
 }
 
 bool TimelineTracksView::draw( const TimelineTrackDrawData& data, TimelineMsgArray* msgArray )
 {
+   // Update according to the options
+   TRACE_HEIGHT = hop::options::traceHeight();
+   PADDED_TRACE_SIZE = TRACE_HEIGHT + TRACE_VERTICAL_PADDING;
+
    bool needs_redraw = false;
    std::vector<HighlightInfo> highlightInfo;
    highlightInfo.reserve( 16 );
@@ -798,7 +912,7 @@ bool TimelineTracksView::draw( const TimelineTrackDrawData& data, TimelineMsgArr
       // Draw the core before the thread labels so they are not drawn over them
       if( !threadHidden && options::showCoreInfo() )
       {
-         drawCoreLabels( labelsDrawPosition, i, data, _tracks[i].coreEventLodsData );
+         drawCoreLabels( labelsDrawPosition, i, data, _tracks[i].coreEventLods, _tracks[i].coreEventLabels );
       }
 
       if( drawThreadLabel( labelsDrawPosition, customName, i, threadHidden ) )
@@ -851,14 +965,14 @@ bool TimelineTracksView::draw( const TimelineTrackDrawData& data, TimelineMsgArr
 
             // Draw the lock waits  entries (before traces so that they are not hiding them)
             const size_t lwHoveredIdx =
-                drawLockWaits( curDrawPos, i, data, _tracks[i].lockwaitsLodsData );
+                drawLockWaits( curDrawPos, i, data, _tracks[i].lockwaitLods, _tracks[i].lockwaitLabels );
 
             if( viewHovered )
                handleHoveredLockWait( *this, data, i, lwHoveredIdx, highlightInfo, msgArray );
 
             // Draw the traces entries
             const size_t traceHoveredIdx =
-                drawTraces( curDrawPos, i, data, _tracks[i].traceLodsData );
+                drawTraces( curDrawPos, i, data, _tracks[i].traceLods, _tracks[i].traceLabels );
 
             if( viewHovered )
                handleHoveredTrace( _contextMenu, data, i, traceHoveredIdx, highlightInfo, msgArray );
@@ -886,6 +1000,80 @@ bool TimelineTracksView::draw( const TimelineTrackDrawData& data, TimelineMsgArr
    return needs_redraw;
 }
 
+void TimelineTracksView::drawMinimap( const TimelineTrackDrawData& data, TimelineMsgArray* msgArray )
+{
+   HOP_PROF_FUNC();
+
+   const ImVec2 drawPos = ImGui::GetCursorScreenPos();
+   const float widthPxl = ImGui::GetWindowWidth();
+   ImGui::InvisibleButton( "Minimap", ImVec2( widthPxl, MINIMAP_HEIGHT ) );
+   const bool clicked = ImGui::IsItemActivated();
+   _minimapDragged    = ImGui::IsItemActive();
+
+   ImDrawList* drawList = ImGui::GetWindowDrawList();
+   drawList->AddRectFilled( drawPos, drawPos + ImVec2( widthPxl, MINIMAP_HEIGHT ), MINIMAP_BG_COLOR );
+
+   // The minimap always displays the whole capture
+   const TimeStamp captureStart       = data.profiler.earliestTimestamp();
+   const TimeDuration captureDuration = data.profiler.latestTimestamp() - captureStart;
+   const uint32_t trackCount          = count();
+   if( captureDuration <= 0 || trackCount == 0 || widthPxl < 1.0f ) return;
+
+   // One row per track, where the opacity of each pixel is the busy fraction of its time
+   static std::vector<float> activity;
+   activity.resize( (size_t)widthPxl );
+   const float rowHeight = MINIMAP_HEIGHT / trackCount;
+   std::vector<renderer::RectInstance>& rects = renderer::addRectBatch( drawList, rowHeight );
+   for( uint32_t i = 0; i < trackCount; ++i )
+   {
+      activityPerPixel( _tracks[i].activity, captureStart, captureDuration, activity );
+      const float posY = drawPos.y + i * rowHeight;
+      for( size_t px = 0; px < activity.size(); )
+      {
+         // Merge the following pixels of the same opacity in a single rect
+         const uint32_t alpha = (uint32_t)( activity[px] * 255.0f );
+         size_t endPx         = px + 1;
+         while( endPx < activity.size() && (uint32_t)( activity[endPx] * 255.0f ) == alpha ) ++endPx;
+         if( alpha > 0 )
+         {
+            rects.push_back( renderer::RectInstance{
+                drawPos.x + px, posY, (float)( endPx - px ), ( alpha << 24 ) | MINIMAP_ACTIVITY_COLOR } );
+         }
+         px = endPx;
+      }
+   }
+
+   // The activity of a lazily opened file only covers the chunks loaded so far
+   if( !data.profiler.fullyLoaded() )
+   {
+      const char* partialText = "partial";
+      const ImVec2 textSize   = ImGui::CalcTextSize( partialText );
+      drawList->AddText(
+          ImVec2( drawPos.x + widthPxl - textSize.x - 5.0f, drawPos.y + ( MINIMAP_HEIGHT - textSize.y ) * 0.5f ),
+          MINIMAP_PARTIAL_TEXT_COLOR,
+          partialText );
+   }
+
+   // Outline the part of the capture displayed by the timeline
+   const TimeStamp visibleStart = data.timeline.globalStartTime + data.timeline.relativeStartTime;
+   const float visibleStartPxl =
+       cyclesToPxl<float>( widthPxl, captureDuration, (int64_t)( visibleStart - captureStart ) );
+   const float visibleWidthPxl = std::max(
+       cyclesToPxl<float>( widthPxl, captureDuration, data.timeline.duration ), MINIMAP_MIN_VISIBLE_WIDTH );
+   drawList->AddRect(
+       ImVec2( drawPos.x + visibleStartPxl, drawPos.y ),
+       ImVec2( drawPos.x + visibleStartPxl + visibleWidthPxl, drawPos.y + MINIMAP_HEIGHT ),
+       MINIMAP_VISIBLE_RANGE_COLOR );
+
+   // Center the timeline on the time under the mouse while the minimap is pressed
+   if( _minimapDragged )
+   {
+      const float mousePxl = hop::clamp( ImGui::GetMousePos().x - drawPos.x, 0.0f, widthPxl );
+      const TimeStamp time = captureStart + pxlToCycles<TimeDuration>( widthPxl, captureDuration, mousePxl );
+      msgArray->addMoveToAbsoluteTimeMsg( time, clicked );
+   }
+}
+
 void TimelineTracksView::drawSearchWindow(
    const hop::TimelineTrackDrawData& data,
    std::vector<HighlightInfo>& traceToHighlight,
@@ -985,6 +1173,12 @@ void TimelineTracksView::drawTraceDetailsWindow(
    }
 }
 
+bool TimelineTracksView::needsWholeCapture() const
+{
+   // The search, the stats and the profiled tracks cover all the traces
+   return _searchResult.searchWindowOpen || _contextMenu.open;
+}
+
 bool TimelineTracksView::handleHotkeys()
 {
    if( ImGui::GetIO().HopLogicalCtrl && ImGui::IsKeyPressed( ImGuiKey_F ) )
@@ -1009,6 +1203,11 @@ bool TimelineTracksView::handleMouse( float, float posY, bool, bool, float )
 
      handled = true;
    }
+   else if( _minimapDragged )
+   {
+      // Do not pan the timeline while navigating with the minimap
+      handled = true;
+   }
 
    return handled;
 }
@@ -1022,11 +1221,13 @@ void TimelineTracksView::setTrackHeight( uint32_t trackIdx, float height )
 void TimelineTracksView::clear()
 {
    _tracks.clear();
+   _lodWorker.clear();
    resetContextMenu( _contextMenu );
    clearSearchResult( _searchResult );
    clearTraceStats( _traceStats );
    clearTraceDetails( _traceDetails );
    _draggedTrack = -1;
+   _minimapDragged = false;
 }
 
 void TimelineTracksView::drawContextMenu( const TimelineTrackDrawData& data )
@@ -1042,7 +1243,7 @@ void TimelineTracksView::drawContextMenu( const TimelineTrackDrawData& data )
              if ( ImGui::Selectable( "Trace Stats" ) )
              {
                 _traceStats = createTraceStats(
-                    data.profiler.timelineTracks()[_contextMenu.threadIndex]._traces,
+                    data.profiler.timelineTracks()[_contextMenu.threadIndex],
                     _contextMenu.threadIndex,
                     _contextMenu.traceId );
              }
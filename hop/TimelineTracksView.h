@@ -1,10 +1,14 @@
 #ifndef TIMELINE_TRACKS_VIEW_H_
 #define TIMELINE_TRACKS_VIEW_H_
 
+#include "hop/ActivityHistogram.h"
 #include "hop/Lod.h"
+#include "hop/LodWorker.h"
 #include "hop/SearchWindow.h"
 #include "hop/TraceStats.h"
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 struct HighlightInfo;
@@ -33,8 +37,16 @@ public:
    float trackHeightWithThreadLabel( uint32_t trackIdx ) const;
    float trackAbsoluteDrawPosY( uint32_t trackIdx ) const;
 
-   void update( const Profiler& profiler );
+   // Returns true if the tracks have changed. Without new data, only the LODs computed
+   // in the background since the last update are fetched.
+   bool update( const Profiler& profiler, bool newData );
    bool draw( const TimelineTrackDrawData& data, TimelineMsgArray* msgArray );
+   // Draw the activity of the tracks over the whole capture. Clicking on it moves the
+   // timeline to the clicked time.
+   void drawMinimap( const TimelineTrackDrawData& data, TimelineMsgArray* msgArray );
+
+   // Returns true while a window or menu that queries the whole capture is open
+   bool needsWholeCapture() const;
 
    // Returns true if the mouse/keys was handled by the tracks
    bool handleHotkeys();
@@ -43,12 +55,46 @@ public:
    void setTrackHeight( uint32_t trackIdx, float height );
    void clear();
 
+   // Labels of the entries drawn in the previous frames with their size in pixels, so
+   // they are not formatted and measured again every frame
+   struct LabelCache
+   {
+      struct Key
+      {
+         size_t index;
+         TimeDuration duration;
+         bool operator==( const Key& rhs ) const
+         {
+            return index == rhs.index && duration == rhs.duration;
+         }
+      };
+      struct KeyHash
+      {
+         size_t operator()( const Key& k ) const { return k.index ^ ( (size_t)k.duration << 1 ); }
+      };
+      struct Label
+      {
+         std::string text;
+         float width, height;
+      };
+      std::unordered_map<Key, Label, KeyHash> labels;
+
+      // State the labels were created with. They are cleared when it changes
+      int zoomBucket{-1};
+      bool useCycles{false};
+      float cpuFreqGHz{0.0f};
+   };
+
    // Per track view data
    struct TrackViewData
    {
-      LodsData traceLodsData;
-      LodsData lockwaitsLodsData;
-      LodsData coreEventLodsData;
+      LodsArray traceLods;
+      LodsArray lockwaitLods;
+      LodsArray coreEventLods;
+      ActivityHistogram activity;
+      LabelCache traceLabels;
+      LabelCache lockwaitLabels;
+      LabelCache coreEventLabels;
       float absoluteDrawPos[2];
       float relativePosY; // The absolute position ignores the scroll but not the relative
       float trackHeight{9999.0f};
@@ -80,7 +126,9 @@ private:
    SearchResult _searchResult;
    TraceDetails _traceDetails;
    TraceStats _traceStats;
+   LodWorker _lodWorker;
    int _draggedTrack{-1};
+   bool _minimapDragged{false};
 };
 
 } // namespace hop
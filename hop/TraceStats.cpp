@@ -256,32 +256,40 @@ gatherTraceDetails( const hop::TraceData& traces, size_t traceId )
    std::vector<TimeStamp> accumulatedTimePerDepth( maxDepth + 1, 0 );
 
    Depth_t lastDepth = traces.entries.depths[firstTraceId];
-   for ( size_t i = firstTraceId; i <= traceId; ++i )
-   {
-      const TimeStamp delta  = traces.entries.ends[i] - traces.entries.starts[i];
-      const Depth_t curDepth = traces.entries.depths[i];
-      TimeStamp excTime = delta;
-
-      if ( curDepth == lastDepth )
-      {
-         accumulatedTimePerDepth[curDepth] += excTime;
-      }
-      else if ( curDepth > lastDepth )
-      {
-         for ( auto j = lastDepth + 1; j < curDepth; ++j ) accumulatedTimePerDepth[j] = 0;
-
-         accumulatedTimePerDepth[curDepth] = excTime;
-      }
-      else if ( curDepth < lastDepth )
-      {
-         excTime -= accumulatedTimePerDepth[lastDepth];
-         accumulatedTimePerDepth[curDepth] += delta;
-      }
-
-      lastDepth = curDepth;
-
-      traceDetails.emplace_back( TraceDetail( i, excTime ) );
-   }
+   forEachSpan(
+       firstTraceId,
+       traceId + 1,
+       [&]( size_t first, size_t count, const TimeStamp* starts, const TimeStamp* ends, const Depth_t* depths ) {
+          for( size_t i = 0; i < count; ++i )
+          {
+             const TimeStamp delta  = ends[i] - starts[i];
+             const Depth_t curDepth = depths[i];
+             TimeStamp excTime      = delta;
+
+             if( curDepth == lastDepth )
+             {
+                accumulatedTimePerDepth[curDepth] += excTime;
+             }
+             else if( curDepth > lastDepth )
+             {
+                for( auto j = lastDepth + 1; j < curDepth; ++j ) accumulatedTimePerDepth[j] = 0;
+
+                accumulatedTimePerDepth[curDepth] = excTime;
+             }
+             else if( curDepth < lastDepth )
+             {
+                excTime -= accumulatedTimePerDepth[lastDepth];
+                accumulatedTimePerDepth[curDepth] += delta;
+             }
+
+             lastDepth = curDepth;
+
+             traceDetails.emplace_back( TraceDetail( first + i, excTime ) );
+          }
+       },
+       traces.entries.starts,
+       traces.entries.ends,
+       traces.entries.depths );
 
    return traceDetails;
 }
@@ -311,6 +319,46 @@ static void finalizeTraceDetails(
    assert( std::abs( totalPct - 1.0f ) < 0.01f || details.empty() );
 }
 
+// Gather the durations of the traces, whose indices are sorted, along with their min
+// and max in a single pass. The indices of a callsite are spread over the whole
+// track, so the columns are read from the raw arrays of their blocks instead of
+// locating every element in the deques.
+static void gatherDurations(
+    const hop::Entries& entries,
+    const std::vector<size_t>& traceIds,
+    std::vector<hop::TimeDuration>& durations,
+    std::vector<float>& displayableDurations,
+    hop::TimeDuration* minDuration,
+    hop::TimeDuration* maxDuration )
+{
+   const size_t count = traceIds.size();
+   durations.resize( count );
+   displayableDurations.resize( count );
+
+   hop::TimeDuration minDur = std::numeric_limits<hop::TimeDuration>::max();
+   hop::TimeDuration maxDur = std::numeric_limits<hop::TimeDuration>::min();
+   for( size_t i = 0; i < count; )
+   {
+      // The arrays start at the first trace of the span
+      const size_t first   = traceIds[i];
+      const size_t spanEnd = std::min( entries.starts.contiguousEnd( first ), entries.ends.contiguousEnd( first ) );
+      const hop::TimeStamp* starts = &entries.starts[first];
+      const hop::TimeStamp* ends   = &entries.ends[first];
+      for( ; i < count && traceIds[i] >= first && traceIds[i] < spanEnd; ++i )
+      {
+         const size_t offset              = traceIds[i] - first;
+         const hop::TimeDuration duration = ends[offset] - starts[offset];
+         durations[i]            = duration;
+         displayableDurations[i] = (float)duration;
+         minDur                  = std::min( minDur, duration );
+         maxDur                  = std::max( maxDur, duration );
+      }
+   }
+
+   *minDuration = minDur;
+   *maxDuration = maxDur;
+}
+
 namespace hop
 {
 TraceDetails
@@ -331,44 +379,22 @@ createTraceDetails( const TraceData& traces, uint32_t threadIndex, size_t traceI
    return details;
 }
 
-TraceStats createTraceStats( const TraceData& traces, uint32_t, size_t traceId )
+TraceStats createTraceStats( const TimelineTrack& track, uint32_t, size_t traceId )
 {
-   const StrPtr_t fileName = traces.fileNameIds[traceId];
-   const StrPtr_t fctName             = traces.fctNameIds[traceId];
-   const LineNb_t lineNb              = traces.lineNbs[traceId];
+   HOP_PROF_FUNC();
+
+   const TraceData& traces = track._traces;
+   const std::vector<size_t>& traceIds = track.tracesOfCallsite( traceId );
 
    TraceStats stats;
-   stats.min       = std::numeric_limits<TimeDuration>::max();
-   stats.max       = 0;
-   stats.median    = 0;
-   stats.count     = 0;
-   stats.fctNameId = fctName;
-   stats.displayableDurations.reserve( 256 );
-   std::vector<float> medianValues;
-   medianValues.reserve( 256 );
-
-   for( size_t i = 0; i < traces.fileNameIds.size(); ++i )
-   {
-      if( traces.fileNameIds[i] == fileName && traces.fctNameIds[i] == fctName &&
-          traces.lineNbs[i] == lineNb )
-      {
-         const TimeDuration delta = traces.entries.ends[i] - traces.entries.starts[i];
-         stats.displayableDurations.push_back( (float)delta );
-         medianValues.push_back( delta );
-         stats.min = std::min( stats.min, delta );
-         stats.max = std::max( stats.max, delta );
-         ++stats.count;
-      }
-   }
+   std::vector<TimeDuration> durations;
+   gatherDurations( traces.entries, traceIds, durations, stats.displayableDurations, &stats.min, &stats.max );
+   stats.count     = durations.size();
+   stats.fctNameId = traces.fctNameIds[traceId];
 
-   if( !medianValues.empty() )
-   {
-      std::nth_element(
-          medianValues.begin(),
-          medianValues.begin() + medianValues.size() / 2,
-          medianValues.end() );
-      stats.median = medianValues[medianValues.size() / 2];
-   }
+   // The durations are only needed in trace order for display, so select in place
+   std::nth_element( durations.begin(), durations.begin() + durations.size() / 2, durations.end() );
+   stats.median = durations[durations.size() / 2];
 
    stats.open = stats.focus = true;
    return stats;
@@ -384,15 +410,21 @@ TraceDetails createGlobalTraceDetails( const TraceData& traces, uint32_t threadI
    traceDetails.reserve( 1024 );
 
    TimeDuration totalTime = 0;
-   for( size_t i = 0; i < traces.entries.depths.size(); ++i )
-   {
-      if( traces.entries.depths[i] == 0 )
-      {
-         totalTime += traces.entries.ends[i] - traces.entries.starts[i];
-         auto details = gatherTraceDetails( traces, i );
-         traceDetails.insert( traceDetails.end(), details.begin(), details.end() );
-      }
-   }
+   forEachSpan(
+       0,
+       traces.entries.depths.size(),
+       [&]( size_t first, size_t count, const Depth_t* depths ) {
+          for( size_t i = 0; i < count; ++i )
+          {
+             if( depths[i] == 0 )
+             {
+                totalTime += traces.entries.ends[first + i] - traces.entries.starts[first + i];
+                auto details = gatherTraceDetails( traces, first + i );
+                traceDetails.insert( traceDetails.end(), details.begin(), details.end() );
+             }
+          }
+       },
+       traces.entries.depths );
 
    auto mergedDetails = mergeTraceDetails( traces, traceDetails );
    finalizeTraceDetails( mergedDetails, totalTime );
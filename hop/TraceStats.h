@@ -64,7 +64,7 @@ TraceDetailDrawResult drawTraceDetails(
     float cpuFreqGHz );
 
 
-TraceStats createTraceStats( const TraceData& traces, uint32_t threadIndex, size_t traceId );
+TraceStats createTraceStats( const TimelineTrack& track, uint32_t threadIndex, size_t traceId );
 void drawTraceStats( TraceStats& stats, const StringDb& strDb, bool drawAsCycles, float cpuFreqGHz );
 void clearTraceDetails( TraceDetails& details );
 void clearTraceStats( TraceStats& stats );
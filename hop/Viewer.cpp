@@ -93,7 +93,7 @@ static void openProfilerFile( std::shared_future< hop::ProfilerView* >& futurePr
              prof = new ProfilerView( Profiler::SRC_TYPE_FILE, -1, path.c_str() );
              if( prof->openFile( path.c_str() ) )
              {
-                // Do the first update here to create the LODs. The params does not make
+                // Do the first update here to start computing the LODs. The params does not make
                 // difference in this scenario as they will be updated once we go back to the
                 // main thread
                 prof->update( 16.0f, 5000000000 );
@@ -105,6 +105,8 @@ static void openProfilerFile( std::shared_future< hop::ProfilerView* >& futurePr
 
              closeModalWindow();
 
+             // The loaded profiler is picked up by the main loop
+             wakeUpMainLoop();
              return prof;
           },
           path );
@@ -548,23 +550,31 @@ static void updateOptions( const hop::ProfilerView* selectedProf, hop::Stats& st
    stats.stringDbSize = profStats.strDbSize;
    stats.traceCount = profStats.traceCount;
    stats.clientSharedMemSize = profStats.clientSharedMemSize;
+   stats.droppedMsgCount = profStats.droppedMsgCount;
+   stats.droppedTraceCount = profStats.droppedTraceCount;
 }
 
-static void updateProfilers(
+// Returns true if the selected profiler has changed
+static bool updateProfilers(
     hop::TimeDuration tlDuration,
     std::vector<std::unique_ptr<hop::ProfilerView> >& profilers,
     int selectedTab )
 {
+   bool needs_redraw = false;
    const float globalTimeMs = ImGui::GetTime() * 1000.0f;
-   for ( auto& p : profilers )
+   for ( size_t i = 0; i < profilers.size(); ++i )
    {
-      p->update( globalTimeMs, tlDuration );
+      const bool changed = profilers[i]->update( globalTimeMs, tlDuration );
+      if( (int)i == selectedTab )
+         needs_redraw = changed;
    }
 
    if( hop::options::showDebugWindow() && selectedTab >= 0 )
    {
       updateOptions( profilers[ selectedTab ].get(), hop::g_stats );
    }
+
+   return needs_redraw;
 }
 
 static bool updateTimeline( hop::Timeline* tl, float deltaMs, const hop::ProfilerView* selectedProf )
@@ -706,6 +716,12 @@ bool Viewer::fetchClientsData()
          needs_redraw = got_data;
    }
 
+   // Load the chunks of lazily opened files up to the end of the visible time range
+   if( _selectedTab >= 0 )
+   {
+      needs_redraw |= _profilers[activeIdx]->loadChunksUntil( _timeline.absoluteEndTime() );
+   }
+
    if ( _pendingProfilerLoad.valid() )
    {
       const auto waitRes = _pendingProfilerLoad.wait_for( std::chrono::microseconds( 200 ) );
@@ -773,8 +789,9 @@ void Viewer::onNewFrame(
 
 bool Viewer::update( float deltaMs )
 {
-   updateProfilers( _timeline.duration(), _profilers, _selectedTab );
-   return updateTimeline( &_timeline, deltaMs, _selectedTab >= 0 ? _profilers[_selectedTab].get() : nullptr );
+   bool needs_redraw = updateProfilers( _timeline.duration(), _profilers, _selectedTab );
+   needs_redraw |= updateTimeline( &_timeline, deltaMs, _selectedTab >= 0 ? _profilers[_selectedTab].get() : nullptr );
+   return needs_redraw;
 }
 
 bool Viewer::draw( float windowWidth, float windowHeight )
@@ -807,6 +824,10 @@ bool Viewer::draw( float windowWidth, float windowHeight )
    drawToolbar( ImGui::GetCursorPos(), windowWidth, selectedProf, &_timeline );
 
    TimelineMsgArray msgArray;
+   if( selectedProf )
+   {
+      selectedProf->drawMinimap( _timeline.createTimelineInfo(), &msgArray );
+   }
    _timeline.draw();
    _timeline.beginDrawCanvas( selectedProf ? selectedProf->canvasHeight() : 0.0f );
 
@@ -15,6 +15,7 @@
 #include <SDL.h>
 #undef main
 
+#include <atomic>
 #include <chrono>
 #include <string>
 
@@ -23,6 +24,20 @@ using ClockType = std::chrono::steady_clock;
 bool g_run = true;
 static SDL_Surface* iconSurface = nullptr;
 
+// Event pushed by the background threads to wake up the main loop when they have new
+// data to display. Only one is queued at a time so busy threads do not flood the queue.
+static uint32_t g_wakeUpEventType = (uint32_t)-1;
+static std::atomic<bool> g_wakeUpEventQueued{false};
+
+static void pushWakeUpEvent()
+{
+   if( g_wakeUpEventQueued.exchange( true ) ) return;
+
+   SDL_Event event = {};
+   event.type      = g_wakeUpEventType;
+   SDL_PushEvent( &event );
+}
+
 static void terminateCallback( int /*sig*/ )
 {
    g_run = false;
@@ -260,6 +275,9 @@ static bool handleEvents(float* mouse_wheel)
             break;
 
          default:
+            // The data of the background threads is fetched after the events
+            if( event.type == g_wakeUpEventType )
+               g_wakeUpEventQueued = false;
             break;
       }
    }
@@ -314,10 +332,16 @@ static hop::ProcessID startViewer( SDL_Window* window, const hop::LaunchOptions&
       viewer.addNewProfiler( opts.processName, opts.startExec );
    }
 
+   g_wakeUpEventType = SDL_RegisterEvents( 1 );
+   hop::setWakeUpCallback( pushWakeUpEvent );
+
    using namespace std::chrono;
    time_point<ClockType> lastFrameTime = ClockType::now();
 
    static constexpr int MAX_NO_REDRAW = 3;
+   // Some state changes do not wake up the loop, like the connection status of the
+   // profiled process, so the idle loop still wakes up from time to time
+   static constexpr int IDLE_TIMEOUT_MS = 500;
    int no_redraw_counter = MAX_NO_REDRAW;
    MouseState prev_mouse_state = {};
    while ( g_run )
@@ -374,8 +398,8 @@ static hop::ProcessID startViewer( SDL_Window* window, const hop::LaunchOptions&
       else
       {
          no_redraw_counter = 0; // Clamp to zero
-         // Nothing happening, go to sleep
-         HOP_SLEEP_MS( 16 );
+         // Nothing happening, sleep until an input event or new data to display
+         SDL_WaitEventTimeout( nullptr, IDLE_TIMEOUT_MS );
       }
 
       prev_mouse_state = mouse;
@@ -385,6 +409,7 @@ static hop::ProcessID startViewer( SDL_Window* window, const hop::LaunchOptions&
       hop::g_stats.frameTimeMs = duration<double, std::milli>( ( frameEnd - frameStart ) ).count();
    }
 
+   hop::setWakeUpCallback( nullptr );
    return childProcId;
 }
 
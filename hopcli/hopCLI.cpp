@@ -16,6 +16,7 @@
 #include <thread>
 
 std::atomic< bool > g_run{true};
+static bool g_saveMappableFile = false;
 
 static const std::string WHITESPACES = " \n\r\t\f\v";
 
@@ -160,6 +161,22 @@ static void printStatus( hop::Profiler* prof )
    const char* recordState = prof->recording() && pid != -1 ? "Recording" : "Not Recording";
    const hop::ProfilerStats stats = prof->stats();
    printf("%s (%d) - [%s] \n\tTraces Count : %zu\n", name, pid, recordState, stats.traceCount );
+   printf(
+       "\tDropped Messages : %zu (%zu traces)\n",
+       stats.droppedMsgCount,
+       stats.droppedTraceCount );
+   for( size_t i = 0; i < stats.droppedPerThread.size(); ++i )
+   {
+      const hop::Server::DroppedData& dropped = stats.droppedPerThread[i];
+      if( dropped.msgCount > 0 )
+      {
+         printf(
+             "\t   Thread %zu : %u messages (%u traces)\n",
+             i,
+             dropped.msgCount,
+             dropped.traceCount );
+      }
+   }
 }
 
 std::mutex commandsMutex;
@@ -256,9 +273,13 @@ static bool processCommands( hop::Profiler* prof )
          break;
       case CMD_TYPE_WRITE_FILE:
       {
-         if( !cmd.arguments.empty() )
+         if( prof->streaming() )
+         {
+            printf( "The recording is already being streamed to the output file\n" );
+         }
+         else if( !cmd.arguments.empty() )
          {
-            if( !prof->saveToFile( cmd.arguments.c_str() ) )
+            if( !prof->saveToFile( cmd.arguments.c_str(), g_saveMappableFile ) )
             {
                printf( "Error while trying to write file to : %s\n", cmd.arguments.c_str() );
             }
@@ -329,6 +350,16 @@ int main( int argc, char* argv[] )
 
    // Add new profiler after having potentially started it.
    profiler = createProfiler( opts.processName, opts.startExec );
+   g_saveMappableFile = opts.mappableFile;
+   if( opts.streamToFile )
+   {
+      if( !profiler->startStreaming( opts.saveFilePath ) )
+      {
+         fprintf( stderr, "Could not stream to %s\n", opts.saveFilePath );
+         exit( -1 );
+      }
+      printf( "Streaming recording to %s\n", opts.saveFilePath );
+   }
 
    // Start the command line interpreter
    g_commands.reserve( 32 );
@@ -351,8 +382,20 @@ int main( int argc, char* argv[] )
 
    assert( opts.saveFilePath );
 
-   printf( "\nSaving file to %s\nThis might take a few seconds\n", opts.saveFilePath );
-   profiler->saveToFile( opts.saveFilePath );
+   if( profiler->streaming() )
+   {
+      // Write what is left of the recording
+      profiler->fetchClientData();
+      if( !profiler->stopStreaming() )
+      {
+         fprintf( stderr, "Failed to write the end of the recording to %s\n", opts.saveFilePath );
+      }
+   }
+   else
+   {
+      printf( "\nSaving file to %s\nThis might take a few seconds\n", opts.saveFilePath );
+      profiler->saveToFile( opts.saveFilePath, g_saveMappableFile );
+   }
 
    // We have launched a child process. Let's close it
    if ( opts.startExec )
@@ -360,6 +403,8 @@ int main( int argc, char* argv[] )
       hop::terminateProcess( childProcId );
    }
 
+   // The profiler data lives in the block allocator, so release it first
+   profiler.reset();
    hop::block_allocator::terminate();
 
    // The interpreter thread will leak since we cannot reliably have a std::getline that is either
@@ -0,0 +1,115 @@
+#define HOP_IMPLEMENTATION
+#include "common/BlockAllocator.h"
+#include "common/TraceData.h"
+#include "hop/ActivityHistogram.h"
+#include "tests/TestUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+static void addEntry( hop::Entries& entries, hop::TimeStamp start, hop::TimeStamp end, hop::Depth_t depth )
+{
+   entries.starts.push_back( start );
+   entries.ends.push_back( end );
+   entries.depths.push_back( depth );
+   entries.maxDepth = std::max( entries.maxDepth, depth );
+}
+
+static bool validHistogram( const hop::ActivityHistogram& hist )
+{
+   const hop::TimeDuration bucketCycles = hop::TimeDuration( 1 ) << hist.bucketShift;
+   if( hist.busy.size() > hop::ACTIVITY_MAX_BUCKET_COUNT ) return false;
+   if( hist.origin % bucketCycles != 0 ) return false;
+   return std::all_of( hist.busy.begin(), hist.busy.end(), [bucketCycles]( hop::TimeDuration busy ) {
+      return busy >= 0 && busy <= bucketCycles;
+   } );
+}
+
+static void testIncrementalActivity( uint32_t seed )
+{
+   std::mt19937 gen( seed );
+   std::uniform_int_distribution<uint32_t> batchDist( 1, 500 );
+   std::uniform_real_distribution<double> exponentDist( 1.0, 9.0 );
+
+   hop::Entries entries;
+   hop::ActivityHistogram hist;
+   hop::TimeStamp time = 1000000000;
+   const hop::TimeStamp captureStart = time;
+   hop::TimeDuration totalBusy = 0;
+   for( int batch = 0; batch < 30; ++batch )
+   {
+      for( uint32_t i = batchDist( gen ); i > 0; --i )
+      {
+         const hop::TimeStamp start = time;
+         const hop::TimeStamp end   = start + (hop::TimeDuration)std::pow( 10.0, exponentDist( gen ) );
+         // The children are already counted in the busy time of their parent
+         addEntry( entries, start, start + ( end - start ) / 2, 1 );
+         addEntry( entries, start, end, 0 );
+         totalBusy += end - start;
+         time = end + (hop::TimeDuration)std::pow( 10.0, exponentDist( gen ) );
+      }
+
+      hop::appendActivity( hist, entries );
+      HOP_TEST_ASSERT_RND( hist.entryCount == entries.ends.size(), seed );
+      HOP_TEST_ASSERT_RND( validHistogram( hist ), seed );
+      HOP_TEST_ASSERT_RND(
+          std::accumulate( hist.busy.begin(), hist.busy.end(), hop::TimeDuration( 0 ) ) == totalBusy, seed );
+   }
+
+   // The busy time spread on the pixels of the whole capture is the same as the total one
+   std::vector<float> activity( 1920 );
+   const hop::TimeDuration captureDuration = time - captureStart;
+   hop::activityPerPixel( hist, captureStart, captureDuration, activity );
+   HOP_TEST_ASSERT_RND( std::all_of( activity.begin(), activity.end(), []( float a ) { return a >= 0.0f && a <= 1.0f; } ), seed );
+   const double pxlCycles  = (double)captureDuration / activity.size();
+   const double pxlBusy    = std::accumulate( activity.begin(), activity.end(), 0.0 ) * pxlCycles;
+   HOP_TEST_ASSERT_RND( std::abs( pxlBusy - totalBusy ) <= 1e-3 * totalBusy, seed );
+}
+
+static void testActivityBounds()
+{
+   hop::Entries entries;
+   hop::ActivityHistogram hist;
+
+   // A single short entry is kept at the finest resolution
+   addEntry( entries, 5000, 5500, 0 );
+   hop::appendActivity( hist, entries );
+   HOP_TEST_ASSERT( hist.bucketShift == hop::ACTIVITY_MIN_BUCKET_SHIFT );
+   HOP_TEST_ASSERT( validHistogram( hist ) );
+
+   // A very long one lowers the resolution instead of growing the histogram
+   addEntry( entries, 10000, 10000 + 1000000000000ll, 0 );
+   hop::appendActivity( hist, entries );
+   HOP_TEST_ASSERT( hist.bucketShift > hop::ACTIVITY_MIN_BUCKET_SHIFT );
+   HOP_TEST_ASSERT( validHistogram( hist ) );
+
+   // An entry before the origin is added at the start of the histogram
+   addEntry( entries, 100, 200, 0 );
+   hop::appendActivity( hist, entries );
+   HOP_TEST_ASSERT( hist.origin <= 100 );
+   HOP_TEST_ASSERT( validHistogram( hist ) );
+   HOP_TEST_ASSERT(
+       std::accumulate( hist.busy.begin(), hist.busy.end(), hop::TimeDuration( 0 ) ) == 500 + 1000000000000ll + 100 );
+
+   // The entry covers the whole middle of the capture
+   std::vector<float> activity( 100 );
+   hop::activityPerPixel( hist, 0, 10000 + 1000000000000ll, activity );
+   HOP_TEST_ASSERT( activity[50] > 0.99f );
+}
+
+int main()
+{
+   hop::block_allocator::initialize( 2048 * HOP_BLK_SIZE_BYTES );
+
+   testActivityBounds();
+
+   std::random_device rd;
+   for( int i = 0; i < 5; ++i )
+   {
+      testIncrementalActivity( rd() );
+   }
+
+   hop::block_allocator::terminate();
+}
@@ -4,8 +4,11 @@
 
 #include <algorithm>
 #include <numeric>
+#include <cstdio>
+#include <fstream>
 #include <vector>
 #include <cmath>
+#include <random>
 
 std::vector< uint32_t > g_values;
 
@@ -176,6 +179,291 @@ void testAppend()
    }
 }
 
+void testAppendMove()
+{
+   const uint32_t cpb = hop::Deque<uint32_t>::COUNT_PER_BLOCK;
+
+   { // Move into an empty deque. The blocks are adopted as is
+      hop::Deque< uint32_t > deq, src;
+      src.append( g_values.data(), cpb + 30 );
+      deq.append( std::move( src ) );
+      HOP_TEST_ASSERT( src.empty() );
+      HOP_TEST_ASSERT( deq.size() == cpb + 30 );
+      for( uint32_t i = 0; i < deq.size(); ++i )
+         HOP_TEST_ASSERT( deq[i] == i );
+   }
+
+   { // Move after a full block, then keep appending to the copied partial block
+      hop::Deque< uint32_t > deq, src;
+      deq.append( g_values.data(), cpb );
+      src.append( g_values.data() + cpb, cpb + 10 );
+      deq.append( std::move( src ) );
+      deq.append( g_values.data() + 2 * cpb + 10, 20 );
+      HOP_TEST_ASSERT( src.empty() );
+      HOP_TEST_ASSERT( deq.size() == 2 * cpb + 30 );
+      HOP_TEST_ASSERT( deq.back() == 2 * cpb + 29 );
+      for( uint32_t i = 0; i < deq.size(); ++i )
+         HOP_TEST_ASSERT( deq[i] == i );
+   }
+
+   { // Move after a partial block. The full blocks are still adopted without copy
+      hop::Deque< uint32_t > deq, src;
+      deq.append( g_values.data(), 50 );
+      src.append( g_values.data() + 50, 2 * cpb );
+      const uint32_t* srcData = &src[0];
+      deq.append( std::move( src ) );
+      HOP_TEST_ASSERT( src.empty() );
+      HOP_TEST_ASSERT( deq.size() == 2 * cpb + 50 );
+      HOP_TEST_ASSERT( &deq[50] == srcData );
+      for( uint32_t i = 0; i < deq.size(); ++i )
+         HOP_TEST_ASSERT( deq[i] == i );
+   }
+
+   { // Move into a deque holding an empty block
+      hop::Deque< uint32_t > deq, src;
+      deq.append( g_values.data(), 0u );
+      src.append( g_values.data(), 10 );
+      deq.append( std::move( src ) );
+      HOP_TEST_ASSERT( deq.size() == 10 );
+      HOP_TEST_ASSERT( deq.front() == 0 && deq.back() == 9 );
+   }
+}
+
+// Build deques from batches of random sizes moved one after the other, which leaves
+// partial blocks in their middle, and check them against the values
+void testSplicedDeques( uint32_t seed )
+{
+   const uint32_t cpb = hop::Deque<uint32_t>::COUNT_PER_BLOCK;
+   std::mt19937 gen( seed );
+   std::uniform_int_distribution<uint32_t> batchDist( 1, 3 * cpb );
+
+   std::vector< uint32_t > values( 16 * cpb );
+   std::iota( values.begin(), values.end(), 0 );
+
+   hop::Deque< uint32_t > small;
+   hop::Deque< uint64_t > large;
+   uint32_t count = 0;
+   while( count < values.size() - 3 * cpb )
+   {
+      const uint32_t batch = batchDist( gen );
+      hop::Deque< uint32_t > smallSrc;
+      hop::Deque< uint64_t > largeSrc;
+      smallSrc.append( values.data() + count, batch );
+      for( uint32_t i = 0; i < batch; ++i )
+         largeSrc.push_back( count + i );
+      small.append( std::move( smallSrc ) );
+      large.append( std::move( largeSrc ) );
+      count += batch;
+   }
+
+   HOP_TEST_ASSERT_RND( small.size() == count && large.size() == count, seed );
+   HOP_TEST_ASSERT_RND( (uint32_t)( small.end() - small.begin() ) == count, seed );
+   for( uint32_t i = 0; i < count; ++i )
+      HOP_TEST_ASSERT_RND( small[i] == i && large[i] == i, seed );
+
+   // Iterators walk over the partial blocks in both directions
+   uint32_t expected = 0;
+   for( auto it = small.begin(); it != small.end(); ++it )
+      HOP_TEST_ASSERT_RND( *it == expected++, seed );
+   HOP_TEST_ASSERT_RND( expected == count, seed );
+   auto it = small.end();
+   while( it != small.begin() )
+      HOP_TEST_ASSERT_RND( *--it == --expected, seed );
+   for( uint32_t i = 0; i < count; i += 997 )
+   {
+      HOP_TEST_ASSERT_RND( *( small.begin() + i ) == i && ( small.end() - ( count - i ) ).index() == i, seed );
+      HOP_TEST_ASSERT_RND( *std::lower_bound( large.begin(), large.end(), i ) == i, seed );
+   }
+
+   // The spans stop at the partial blocks of both deques
+   uint64_t next = 3;
+   hop::forEachSpan(
+       3,
+       count,
+       [&]( uint64_t first, uint64_t spanCount, const uint32_t* smallData, const uint64_t* largeData ) {
+          HOP_TEST_ASSERT_RND( first == next && spanCount > 0, seed );
+          for( uint64_t i = 0; i < spanCount; ++i )
+             HOP_TEST_ASSERT_RND( smallData[i] == first + i && largeData[i] == first + i, seed );
+          next += spanCount;
+       },
+       small,
+       large );
+   HOP_TEST_ASSERT_RND( next == count, seed );
+
+   // Copies keep the layout, and erasing packs the blocks first
+   hop::Deque< uint32_t > copy = small;
+   for( uint32_t i = 0; i < count; ++i )
+      HOP_TEST_ASSERT_RND( copy[i] == i, seed );
+   copy.erase( copy.begin() + 10, copy.begin() + 10 + cpb );
+   HOP_TEST_ASSERT_RND( copy.size() == count - cpb && copy[10] == 10 + cpb, seed );
+   HOP_TEST_ASSERT_RND( std::is_sorted( copy.begin(), copy.end() ), seed );
+
+   // Removing the elements and appending new ones goes through the partial blocks
+   small.pop_back( count / 2 );
+   small.append( values.data() + count - count / 2, count / 2 );
+   for( uint32_t i = 0; i < count; ++i )
+      HOP_TEST_ASSERT_RND( small[i] == i, seed );
+   small.pop_back( count - 1 );
+   HOP_TEST_ASSERT_RND( small.size() == 1 && small.back() == 0 && small.end() - small.begin() == 1, seed );
+}
+
+void testMoveSplicedDeque()
+{
+   // A deque built by splicing has a partial block before its last one. Moving it
+   // again must keep the starts of its blocks, even into a deque without any block.
+   const uint32_t cpb = hop::Deque<uint64_t>::COUNT_PER_BLOCK;
+   for( uint32_t n1 : {1u, 10u, cpb - 1} )
+   {
+      for( uint32_t n2 : {cpb, cpb + 1, 2 * cpb + 3} )
+      {
+         // Empty, emptied by popping all its elements, and ending with a full block
+         for( uint32_t dstCount : {0u, 5u, cpb} )
+         {
+            hop::Deque< uint64_t > spliced, src1, src2;
+            for( uint32_t i = 0; i < n1; ++i )
+               src1.push_back( i );
+            for( uint32_t i = 0; i < n2; ++i )
+               src2.push_back( n1 + i );
+            spliced.append( std::move( src1 ) );
+            spliced.append( std::move( src2 ) );
+
+            hop::Deque< uint64_t > dst;
+            for( uint32_t i = 0; i < dstCount; ++i )
+               dst.push_back( i );
+            const uint32_t kept = dstCount == cpb ? cpb : 0;
+            dst.pop_back( dstCount - kept );
+            dst.append( std::move( spliced ) );
+
+            const uint64_t count = kept + n1 + n2;
+            HOP_TEST_ASSERT( spliced.empty() && dst.size() == count );
+            for( uint64_t i = 0; i < count; ++i )
+               HOP_TEST_ASSERT( dst[i] == ( i < kept ? i : i - kept ) );
+            uint64_t idx = 0;
+            for( auto it = dst.cbegin(); it != dst.cend(); ++it, ++idx )
+               HOP_TEST_ASSERT( *it == ( idx < kept ? idx : idx - kept ) );
+            HOP_TEST_ASSERT( idx == count );
+
+            // Appending after it keeps going through the same blocks
+            dst.push_back( 42 );
+            HOP_TEST_ASSERT( dst[count] == 42 && dst.back() == 42 && dst[count - 1] == n1 + n2 - 1 );
+         }
+      }
+   }
+}
+
+void testAdoptBlocks()
+{
+   const uint32_t cpb = hop::Deque<uint32_t>::COUNT_PER_BLOCK;
+
+   // The unused end of the last block is skipped, which only works with file streams
+   const char* path = "Deque_test_blocks.bin";
+   uint64_t blocksSize = 0;
+   {
+      hop::Deque< uint32_t > src;
+      src.append( g_values.data(), 2 * cpb + 20 );
+      std::ofstream out( path, std::ofstream::binary );
+      src.writeBlocks( out );
+      HOP_TEST_ASSERT( out.good() );
+      blocksSize = src.blocksSizeInBytes();
+
+      // Spliced deques are written with full blocks as well
+      hop::Deque< uint32_t > spliced, splicedSrc;
+      spliced.append( g_values.data(), 20 );
+      splicedSrc.append( g_values.data() + 20, 2 * cpb );
+      spliced.append( std::move( splicedSrc ) );
+      std::ofstream splicedOut( "Deque_test_spliced.bin", std::ofstream::binary );
+      spliced.writeBlocks( splicedOut );
+      HOP_TEST_ASSERT( splicedOut.good() && spliced.blocksSizeInBytes() == blocksSize );
+   }
+   {
+      std::ifstream splicedIn( "Deque_test_spliced.bin", std::ifstream::binary );
+      std::vector<char> splicedBlocks( blocksSize );
+      splicedIn.read( splicedBlocks.data(), splicedBlocks.size() );
+      std::remove( "Deque_test_spliced.bin" );
+      hop::Deque< uint32_t > deq;
+      deq.adoptBlocks( splicedBlocks.data(), 2 * cpb + 20 );
+      for( uint32_t i = 0; i < deq.size(); ++i )
+         HOP_TEST_ASSERT( deq[i] == i );
+   }
+
+   // Use the written blocks in place. They must not reach the block allocator when released.
+   std::ifstream in( path, std::ifstream::binary );
+   std::vector<char> blocks( blocksSize );
+   in.read( blocks.data(), blocks.size() );
+   HOP_TEST_ASSERT( in.gcount() <= (std::streamsize)blocksSize );
+   std::remove( path );
+   {
+      hop::Deque< uint32_t > deq;
+      deq.adoptBlocks( blocks.data(), 2 * cpb + 20 );
+      HOP_TEST_ASSERT( deq.size() == 2 * cpb + 20 );
+      for( uint32_t i = 0; i < deq.size(); ++i )
+         HOP_TEST_ASSERT( deq[i] == i );
+
+      // Fill the adopted partial block and continue in a block from the allocator
+      deq.append( g_values.data() + 2 * cpb + 20, cpb );
+      HOP_TEST_ASSERT( deq.size() == 3 * cpb + 20 );
+      HOP_TEST_ASSERT( deq.back() == 3 * cpb + 19 );
+      HOP_TEST_ASSERT( std::is_sorted( deq.begin(), deq.end() ) );
+   }
+
+   // The allocator still hands out valid blocks
+   hop::Deque< uint32_t > deq;
+   deq.append( g_values.data(), 2 * cpb );
+   for( uint32_t i = 0; i < deq.size(); ++i )
+      HOP_TEST_ASSERT( deq[i] == i );
+}
+
+void testForEachSpan()
+{
+   hop::Deque< uint32_t > small;
+   hop::Deque< uint64_t > large;
+   small.append( g_values.data(), g_values.size() );
+   for( uint32_t v : g_values )
+      large.push_back( v );
+
+   // The spans follow the blocks of the deque with the largest type
+   const uint64_t from = 5, to = g_values.size() - 3;
+   uint64_t next = from, spanCount = 0;
+   hop::forEachSpan(
+       from,
+       to,
+       [&]( uint64_t first, uint64_t count, const uint32_t* smallData, const uint64_t* largeData ) {
+          HOP_TEST_ASSERT( first == next && count > 0 );
+          HOP_TEST_ASSERT( count <= hop::Deque<uint64_t>::COUNT_PER_BLOCK );
+          for( uint64_t i = 0; i < count; ++i )
+             HOP_TEST_ASSERT( smallData[i] == first + i && largeData[i] == first + i );
+          next += count;
+          ++spanCount;
+       },
+       small,
+       large );
+   HOP_TEST_ASSERT( next == to );
+   HOP_TEST_ASSERT( spanCount == ( to - 1 ) / hop::Deque<uint64_t>::COUNT_PER_BLOCK + 1 );
+
+   // An empty range does not call the function
+   hop::forEachSpan( 10, 10, []( uint64_t, uint64_t, const uint32_t* ) { HOP_TEST_ASSERT( false ); }, small );
+}
+
+void testPopBack()
+{
+   const size_t blockSize = hop::Deque<uint32_t>::COUNT_PER_BLOCK;
+   hop::Deque< uint32_t > deq;
+   deq.append( g_values.data(), blockSize * 2 + 10 );
+
+   // Within the last block, then across blocks
+   deq.pop_back();
+   deq.pop_back( 9 );
+   HOP_TEST_ASSERT( deq.size() == blockSize * 2 && deq.back() == blockSize * 2 - 1 );
+   deq.pop_back( blockSize + 5 );
+   HOP_TEST_ASSERT( deq.size() == blockSize - 5 && deq.back() == blockSize - 6 );
+
+   // The deque can still be appended to
+   deq.push_back( 42 );
+   HOP_TEST_ASSERT( deq.size() == blockSize - 4 && deq.back() == 42 );
+   deq.pop_back( deq.size() );
+   HOP_TEST_ASSERT( deq.empty() && deq.begin() == deq.end() );
+}
+
 void testErase()
 {
    hop::Deque<uint32_t> deq;
@@ -389,6 +677,16 @@ int main()
 
    testIterators( deq );
    testAppend();
+   testAppendMove();
+   {
+      std::random_device rd;
+      for( int i = 0; i < 3; ++i )
+         testSplicedDeques( rd() );
+   }
+   testMoveSplicedDeque();
+   testAdoptBlocks();
+   testForEachSpan();
+   testPopBack();
    testErase();
    testCopy();
 
@@ -0,0 +1,182 @@
+#define HOP_IMPLEMENTATION
+#include "common/BlockAllocator.h"
+#include "common/TraceData.h"
+#include "hop/Lod.h"
+#include "hop/LodWorker.h"
+#include "tests/TestUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+// Durations and gaps spread over all the LOD levels
+static hop::TimeDuration randomCycles( std::mt19937& gen )
+{
+   std::uniform_real_distribution<double> exponentDist( 1.0, 10.0 );
+   return (hop::TimeDuration)std::pow( 10.0, exponentDist( gen ) );
+}
+
+// Add the traces of a call and its children, in the order of their end time like
+// the profiled threads send them
+static hop::TimeStamp addCall( hop::Entries& entries, hop::TimeStamp start, hop::Depth_t depth, std::mt19937& gen )
+{
+   std::uniform_int_distribution<uint32_t> childDist( 0, depth < 6 ? 4 : 0 );
+   hop::TimeStamp end = start + randomCycles( gen ) / 8;
+   for( uint32_t i = childDist( gen ); i > 0; --i )
+   {
+      end = addCall( entries, end, depth + 1, gen ) + randomCycles( gen ) / 8;
+   }
+
+   entries.starts.push_back( start );
+   entries.ends.push_back( end );
+   entries.depths.push_back( depth );
+   entries.maxDepth = std::max( entries.maxDepth, depth );
+   return end;
+}
+
+static bool sameLods( const hop::LodsArray& lhs, const hop::LodsArray& rhs )
+{
+   for( int lvl = 0; lvl < hop::LOD_COUNT; ++lvl )
+   {
+      if( lhs[lvl].size() != rhs[lvl].size() ) return false;
+      for( size_t i = 0; i < lhs[lvl].size(); ++i )
+      {
+         const hop::LodInfo& l = lhs[lvl][i];
+         const hop::LodInfo& r = rhs[lvl][i];
+         if( l.start != r.start || l.end != r.end || l.index != r.index || l.depth != r.depth || l.loded != r.loded )
+            return false;
+      }
+   }
+   return true;
+}
+
+static void testIncrementalLods( uint32_t seed )
+{
+   std::mt19937 gen( seed );
+   std::uniform_int_distribution<uint32_t> batchDist( 1, 20 );
+
+   hop::Entries entries;
+   hop::LodsData incremental;
+   hop::TimeStamp time = 0;
+   for( int batch = 0; batch < 30; ++batch )
+   {
+      hop::Entries newEntries;
+      for( uint32_t i = batchDist( gen ); i > 0; --i )
+      {
+         time = addCall( newEntries, time, 0, gen ) + randomCycles( gen );
+      }
+      entries.append( newEntries );
+
+      // The LODs appended in batches are the same as if all the traces were added at once
+      hop::appendLods( incremental, newEntries );
+      hop::LodsData reference;
+      hop::appendLods( reference, entries );
+      HOP_TEST_ASSERT_RND( sameLods( incremental.lods, reference.lods ), seed );
+   }
+
+   for( const auto& lods : incremental.lods )
+   {
+      HOP_TEST_ASSERT_RND( std::is_sorted( lods.begin(), lods.end() ), seed );
+   }
+   // The first level has all the traces, the next ones have less and less of them
+   HOP_TEST_ASSERT_RND( incremental.lods[0].size() == entries.ends.size(), seed );
+   for( int lvl = 1; lvl < hop::LOD_COUNT; ++lvl )
+   {
+      HOP_TEST_ASSERT_RND( incremental.lods[lvl].size() <= incremental.lods[lvl - 1].size(), seed );
+   }
+   HOP_TEST_ASSERT_RND( incremental.lods[hop::LOD_COUNT - 1].size() < entries.ends.size(), seed );
+}
+
+static void testIncrementalCoreEventLods( uint32_t seed )
+{
+   std::mt19937 gen( seed );
+   std::uniform_int_distribution<uint32_t> batchDist( 1, 2000 );
+   std::uniform_int_distribution<hop::Core_t> coreDist( 0, 3 );
+
+   hop::Entries entries;
+   hop::Deque<hop::Core_t> cores;
+   hop::LodsData incremental;
+   hop::TimeStamp time = 0;
+   for( int batch = 0; batch < 30; ++batch )
+   {
+      hop::Entries newEntries;
+      hop::Deque<hop::Core_t> newCores;
+      for( uint32_t i = batchDist( gen ); i > 0; --i )
+      {
+         newEntries.starts.push_back( time );
+         time += randomCycles( gen ) / 16;
+         newEntries.ends.push_back( time );
+         newEntries.depths.push_back( 0 );
+         newCores.push_back( coreDist( gen ) );
+         time += randomCycles( gen ) / 16;
+      }
+      entries.append( newEntries );
+      cores.append( newCores.begin(), newCores.end() );
+
+      hop::appendCoreEventLods( incremental, newEntries, newCores );
+      hop::LodsData reference;
+      hop::appendCoreEventLods( reference, entries, cores );
+      HOP_TEST_ASSERT_RND( sameLods( incremental.lods, reference.lods ), seed );
+   }
+
+   for( const auto& lods : incremental.lods )
+   {
+      HOP_TEST_ASSERT_RND( std::is_sorted( lods.begin(), lods.end() ), seed );
+   }
+}
+
+static void waitForLods( hop::LodWorker& worker )
+{
+   while( !worker.takeNewLodsFlag() )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+}
+
+static void testLodWorker( uint32_t seed )
+{
+   std::mt19937 gen( seed );
+   std::uniform_int_distribution<size_t> extraDist( 0, hop::Deque<hop::LodInfo>::COUNT_PER_BLOCK );
+
+   hop::Entries entries;
+   hop::LodsArray collected;
+   hop::LodWorker worker;
+   hop::TimeStamp time = 0;
+   for( int collectCount = 0; collectCount < 3; ++collectCount )
+   {
+      // The worker runs several times before the LODs are collected, so the updates
+      // of more than a block are spliced before being moved in the collected ones
+      for( int run = 0; run < 3; ++run )
+      {
+         const size_t target =
+             entries.ends.size() + hop::Deque<hop::LodInfo>::COUNT_PER_BLOCK + extraDist( gen );
+         while( entries.ends.size() < target )
+         {
+            time = addCall( entries, time, 0, gen ) + randomCycles( gen );
+         }
+         worker.submit( 0, hop::LodWorker::TRACES, entries );
+         waitForLods( worker );
+      }
+      HOP_TEST_ASSERT_RND( worker.collect( 0, hop::LodWorker::TRACES, collected ), seed );
+
+      hop::LodsData reference;
+      hop::appendLods( reference, entries );
+      HOP_TEST_ASSERT_RND( sameLods( collected, reference.lods ), seed );
+   }
+}
+
+int main()
+{
+   hop::block_allocator::initialize( 2048 * HOP_BLK_SIZE_BYTES );
+   hop::setupLODResolution( 1920 );
+
+   std::random_device rd;
+   for( int i = 0; i < 5; ++i )
+   {
+      testIncrementalLods( rd() );
+      testIncrementalCoreEventLods( rd() );
+   }
+   testLodWorker( rd() );
+
+   hop::block_allocator::terminate();
+}
@@ -0,0 +1,77 @@
+#include "common/SpscQueue.h"
+#include "tests/TestUtils.h"
+
+#include <thread>
+#include <vector>
+
+struct Batch
+{
+   std::vector< uint32_t > values;
+   void swap( Batch& rhs ) { values.swap( rhs.values ); }
+};
+
+static void testSingleThread()
+{
+   hop::SpscQueue< Batch, 4 > queue;
+   Batch batch;
+   HOP_TEST_ASSERT( queue.empty() );
+   HOP_TEST_ASSERT( !queue.pop( batch ) );
+
+   for( uint32_t i = 0; i < 4; ++i )
+   {
+      batch.values.assign( 1, i );
+      HOP_TEST_ASSERT( queue.push( batch ) );
+   }
+
+   // The queue is full, the batch must be left untouched
+   batch.values.assign( 1, 4 );
+   HOP_TEST_ASSERT( !queue.push( batch ) );
+   HOP_TEST_ASSERT( batch.values.size() == 1 && batch.values[0] == 4 );
+
+   for( uint32_t i = 0; i < 4; ++i )
+   {
+      HOP_TEST_ASSERT( queue.pop( batch ) );
+      HOP_TEST_ASSERT( batch.values.size() == 1 && batch.values[0] == i );
+   }
+   HOP_TEST_ASSERT( queue.empty() );
+}
+
+static void testProducerConsumer()
+{
+   const uint32_t valueCount = 1000000;
+   hop::SpscQueue< Batch, 8 > queue;
+
+   std::thread producer( [&queue, valueCount]() {
+      Batch batch;
+      uint32_t next = 0;
+      while( next < valueCount || !batch.values.empty() )
+      {
+         // Keep accumulating while the queue is full
+         if( next < valueCount ) batch.values.push_back( next++ );
+         if( queue.push( batch ) ) batch.values.clear();
+      }
+   } );
+
+   Batch batch;
+   uint32_t expected = 0;
+   bool inOrder      = true;
+   while( expected < valueCount )
+   {
+      if( !queue.pop( batch ) ) continue;
+      for( uint32_t v : batch.values )
+      {
+         inOrder &= v == expected++;
+      }
+   }
+   producer.join();
+
+   HOP_TEST_ASSERT( inOrder );
+   HOP_TEST_ASSERT( expected == valueCount );
+   HOP_TEST_ASSERT( queue.empty() );
+}
+
+int main()
+{
+   testSingleThread();
+   testProducerConsumer();
+}
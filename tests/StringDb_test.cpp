@@ -0,0 +1,70 @@
+#include "common/StringDb.h"
+#include "common/Utils.h"
+#include "tests/TestUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+
+// Append a string to the db input data, in the format sent by the client
+static void addString( std::vector<char>& data, hop::StrPtr_t strPtr, const std::string& str )
+{
+   const size_t start = data.size();
+   data.resize( start + sizeof( strPtr ) + ( ( str.size() + 1 + 7 ) & ~7 ), '\0' );
+   memcpy( &data[start], &strPtr, sizeof( strPtr ) );
+   memcpy( &data[start + sizeof( strPtr )], str.c_str(), str.size() );
+}
+
+static void testFindMatching( uint32_t seed, bool searchable )
+{
+   std::mt19937 gen( seed );
+   // Small alphabet so that queries have several matches
+   const char alphabet[] = "abcABC_:";
+   std::uniform_int_distribution<uint32_t> charDist( 0, sizeof( alphabet ) - 2 );
+   std::uniform_int_distribution<uint32_t> lengthDist( 0, 24 );
+
+   std::vector<std::string> strings;
+   std::vector<char> data;
+   hop::StringDb db( searchable );
+   for( int batch = 0; batch < 3; ++batch )
+   {
+      data.clear();
+      for( int i = 0; i < 500; ++i )
+      {
+         std::string str;
+         for( uint32_t c = lengthDist( gen ); c > 0; --c ) str += alphabet[charDist( gen )];
+         strings.push_back( str );
+         addString( data, strings.size(), str );
+      }
+      db.addStringData( data );
+   }
+
+   std::uniform_int_distribution<uint32_t> queryLengthDist( 1, 6 );
+   for( int q = 0; q < 200; ++q )
+   {
+      std::string query;
+      for( uint32_t c = queryLengthDist( gen ); c > 0; --c ) query += alphabet[charDist( gen )];
+
+      std::vector<size_t> expected;
+      for( size_t i = 0; i < strings.size(); ++i )
+      {
+         if( hop::findSubstrNoCase( strings[i].c_str(), strings[i].size(), query.c_str(), query.size() ) != -1 )
+            expected.push_back( db.getStringIndex( i + 1 ) );
+      }
+
+      const std::vector<size_t> found = db.findStringIndexMatching( query.c_str() );
+      HOP_TEST_ASSERT_RND( found == expected, seed );
+   }
+}
+
+int main()
+{
+   std::random_device rd;
+   for( int i = 0; i < 5; ++i )
+   {
+      // Without the index, all the strings are scanned instead
+      testFindMatching( rd(), true );
+      testFindMatching( rd(), false );
+   }
+}
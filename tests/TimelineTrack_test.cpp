@@ -0,0 +1,77 @@
+#define HOP_IMPLEMENTATION
+#include "common/BlockAllocator.h"
+#include "common/TimelineTrack.h"
+#include "tests/TestUtils.h"
+
+#include <algorithm>
+#include <random>
+
+static hop::TraceData createTraces( uint32_t count, hop::TimeStamp* time, std::mt19937& gen )
+{
+   // Callsites that only differ by one of their fields
+   std::uniform_int_distribution<uint32_t> callsiteDist( 0, 63 );
+
+   hop::TraceData traces;
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      const uint32_t callsite = callsiteDist( gen );
+      traces.entries.starts.push_back( *time );
+      traces.entries.ends.push_back( ++( *time ) );
+      traces.entries.depths.push_back( 0 );
+      traces.fctNameIds.push_back( callsite % 16 );
+      traces.fileNameIds.push_back( callsite % 2 );
+      traces.lineNbs.push_back( callsite / 16 );
+      traces.zones.push_back( 0 );
+   }
+   return traces;
+}
+
+static void testCallsiteTraces( uint32_t seed )
+{
+   std::mt19937 gen( seed );
+   std::uniform_int_distribution<uint32_t> batchDist( 0, 100000 );
+
+   // Add the traces in a few batches so the index is updated incrementally
+   hop::TimelineTrack track;
+   hop::TimeStamp time = 0;
+   for( int batch = 0; batch < 4; ++batch )
+   {
+      track.addTraces( createTraces( batchDist( gen ), &time, gen ) );
+   }
+
+   const hop::TraceData& traces = track._traces;
+   size_t indexedCount = 0;
+   for( const auto& callsite : track._tracesPerCallsite )
+   {
+      const std::vector<size_t>& ids = callsite.second;
+      HOP_TEST_ASSERT_RND( !ids.empty(), seed );
+      HOP_TEST_ASSERT_RND( std::is_sorted( ids.begin(), ids.end() ), seed );
+      for( size_t idx : ids )
+      {
+         HOP_TEST_ASSERT_RND( traces.fileNameIds[idx] == callsite.first.fileName, seed );
+         HOP_TEST_ASSERT_RND( traces.fctNameIds[idx] == callsite.first.fctName, seed );
+         HOP_TEST_ASSERT_RND( traces.lineNbs[idx] == callsite.first.lineNb, seed );
+      }
+      indexedCount += ids.size();
+   }
+   HOP_TEST_ASSERT_RND( indexedCount == traces.fctNameIds.size(), seed );
+
+   for( size_t i = 0; i < traces.fctNameIds.size(); i += 997 )
+   {
+      const std::vector<size_t>& ids = track.tracesOfCallsite( i );
+      HOP_TEST_ASSERT_RND( std::binary_search( ids.begin(), ids.end(), i ), seed );
+   }
+}
+
+int main()
+{
+   hop::block_allocator::initialize( 2048 * HOP_BLK_SIZE_BYTES );
+
+   std::random_device rd;
+   for( int i = 0; i < 5; ++i )
+   {
+      testCallsiteTraces( rd() );
+   }
+
+   hop::block_allocator::terminate();
+}